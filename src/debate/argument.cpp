@@ -1,8 +1,10 @@
 #include "./argument.hpp"
 
 #include "./detail/reflow.hpp"
+#include "./detail/string_pool.hpp"
 #include "./error.hpp"
 
+#include <boost/leaf/exception.hpp>
 #include <neo/tokenize.hpp>
 
 #include <algorithm>
@@ -16,9 +18,15 @@ namespace stdr = std::ranges;
 using namespace std::literals;
 
 struct debate::detail::argument_data {
+    /// The parameters, except for the strings that have been moved into the pool
     debate::params::for_argument params;
 
     bool is_positional;
+
+    std::shared_ptr<detail::string_pool> pool;
+    std::vector<std::string_view>        names;
+    std::optional<std::string_view>      metavar;
+    std::optional<std::string_view>      help;
 };
 
 const params::for_argument& argument::_params() const noexcept { return (*this)->params; }
@@ -27,13 +35,33 @@ bool argument::is_positional() const noexcept { return (*this)->is_positional; }
 bool argument::can_repeat() const noexcept { return _params().can_repeat; }
 bool argument::is_required() const noexcept { return _params().required == true; }
 bool argument::wants_value() const noexcept { return _params().wants_value; }
+std::optional<value_count> argument::nargs() const noexcept { return _params().nargs; }
+std::optional<char>        argument::delimiter() const noexcept { return _params().delimiter; }
+const std::optional<argument_default>& argument::default_value() const noexcept {
+    return _params().default_value;
+}
+std::span<const std::string_view> argument::names() const noexcept { return (*this)->names; }
+std::optional<std::string_view>   argument::metavar() const noexcept { return (*this)->metavar; }
+std::optional<std::string_view>   argument::help() const noexcept { return (*this)->help; }
+const std::optional<choice_set>& argument::choices() const noexcept { return _params().choices; }
+void argument::add_memory_usage(memory_report& report) const noexcept {
+    // The shared state and its control block. The string pool is counted by the parser tree.
+    report.arguments += sizeof(detail::argument_data) + 2 * sizeof(void*)
+        - sizeof(_params().action) - sizeof(_params().validate);
+    report.actions += sizeof(_params().action) + sizeof(_params().validate);
+    report.names += (*this)->names.capacity() * sizeof(std::string_view);
+    if (auto& ch = choices()) {
+        report.indexes += ch->memory_usage();
+    }
+}
+
 // The "preferred name" appears in diagnostics
-std::string_view argument::preferred_name() const noexcept { return _params().names.front(); }
+std::string_view argument::preferred_name() const noexcept { return names().front(); }
 enum category    argument::category() const noexcept { return _params().category; }
 
 std::string argument::value_name() const noexcept {
-    if (_params().metavar.has_value()) {
-        return *_params().metavar;
+    if (metavar().has_value()) {
+        return std::string(*metavar());
     }
     if (is_positional()) {
         return neo::ufmt("<{}>", preferred_name());
@@ -46,11 +74,47 @@ std::string argument::value_name() const noexcept {
     }
 }
 
+namespace {
+
+/// The syntax of the value(s) given with each occurrence of an argument
+std::string value_syntax(const argument& arg) {
+    auto one = arg.value_name();
+    if (auto delim = arg.delimiter()) {
+        one = neo::str_concat(one, "[", std::string(1, *delim), "...]");
+    }
+    auto count = arg.nargs();
+    if (not count) {
+        return one;
+    }
+    std::string ret;
+    if (count->min > 3) {
+        ret = neo::str_concat(one, "{", std::to_string(count->min), "}");
+    } else {
+        for (std::size_t i = 0; i < count->min; ++i) {
+            ret.append(i ? " " : "").append(one);
+        }
+    }
+    if (count->max > count->min) {
+        ret.append(ret.empty() ? "" : " ");
+        ret.append(count->max - count->min == 1 ? neo::str_concat("[", one, "]")
+                                                : neo::str_concat("[", one, " ...]"));
+    }
+    return ret;
+}
+
+/// Whether an occurrence of the argument can take its values from the following words only
+bool takes_many_words(const argument& arg) { return arg.nargs() and arg.nargs()->max > 1; }
+
+}  // namespace
+
 std::string argument::syntax_string() const noexcept {
     std::string ret;
     auto        pref_spell = preferred_name();
-    std::string valname    = value_name();
-    if (is_positional()) {
+    std::string valname    = value_syntax(*this);
+    if (is_positional() and nargs()) {
+        // The count already says which values are optional
+        ret.append(valname);
+    } else if (is_positional()) {
         if (is_required()) {
             if (can_repeat()) {
                 ret.append(neo::ufmt("{} [{} [...]]", valname, valname));
@@ -65,7 +129,7 @@ std::string argument::syntax_string() const noexcept {
             }
         }
     } else if (wants_value()) {
-        char sep_char = pref_spell.starts_with("--") ? '=' : ' ';
+        char sep_char = pref_spell.starts_with("--") and not takes_many_words(*this) ? '=' : ' ';
         if (is_required()) {
             ret.append(neo::ufmt("{}{}{}", pref_spell, sep_char, valname));
             if (can_repeat()) {
@@ -92,15 +156,15 @@ std::string argument::syntax_string() const noexcept {
 
 std::string argument::help_string() const noexcept {
     std::string ret;
-    auto        valname = value_name();
+    auto        valname = value_syntax(*this);
     if (is_positional()) {
         ret = valname;
     } else {
-        auto names = _params().names  //
+        auto names = this->names()  //
             | std::views::transform([&](auto& name) {
                          if (not wants_value()) {
-                             return name;
-                         } else if (name.starts_with("--")) {
+                             return std::string(name);
+                         } else if (name.starts_with("--") and not takes_many_words(*this)) {
                              return neo::ufmt("{}={}", name, valname);
                          } else {
                              return neo::ufmt("{} {}", name, valname);
@@ -110,10 +174,18 @@ std::string argument::help_string() const noexcept {
         ret.append(std::string(names));
     }
     ret.append("\n");
-    if (_params().help) {
-        auto help = detail::reflow_text(*_params().help, "   ", 79);
+    if (help()) {
+        auto help = detail::reflow_text(*this->help(), "   ", 79);
         ret.append(std::string(neo::str_concat(" ➥ ", neo::trim(help), "\n")));
     }
+    if (_params().choices and wants_value()) {
+        auto choices = detail::reflow_text("Choices: " + _params().choices->joined(), "   ", 79);
+        ret.append(std::string(neo::str_concat(" ➥ ", neo::trim(choices), "\n")));
+    }
+    if (auto dflt = _params().default_value ? _params().default_value->literal() : std::nullopt) {
+        auto text = detail::reflow_text(neo::ufmt("Default: {}", *dflt), "   ", 79);
+        ret.append(std::string(neo::str_concat(" ➥ ", neo::trim(text), "\n")));
+    }
 
     return ret;
 }
@@ -124,7 +196,10 @@ bool is_positional_word(std::string_view sp) { return not sp.starts_with("-"); }
 
 }  // namespace
 
-argument::argument(params::for_argument p_) {
+argument::argument(params::for_argument p)
+    : argument(std::move(p), std::make_shared<detail::string_pool>()) {}
+
+argument::argument(params::for_argument p_, std::shared_ptr<detail::string_pool> pool) {
     detail::argument_data& impl = *this;
     impl.params                 = std::move(p_);
 
@@ -132,10 +207,26 @@ argument::argument(params::for_argument p_) {
         throw invalid_argument_params{".names must be non-empty"};
     }
 
+    if ((impl.params.nargs or impl.params.delimiter) and not impl.params.wants_value) {
+        throw invalid_argument_params{".nargs and .delimiter require .wants_value"};
+    }
+
+    if (impl.params.default_value) {
+        if (not impl.params.wants_value) {
+            throw invalid_argument_params{".default_value requires .wants_value"};
+        }
+        if (impl.params.required == true) {
+            throw invalid_argument_params{"A required argument cannot have a .default_value"};
+        }
+        // A positional argument with a default may be omitted
+        impl.params.required = false;
+    }
+
     if (impl.params.names.size() == 1) {
         impl.is_positional = is_positional_word(impl.params.names.front());
         if (impl.is_positional and not impl.params.required.has_value()) {
-            impl.params.required = true;
+            // A positional argument that accepts zero values may be omitted
+            impl.params.required = not(impl.params.nargs and impl.params.nargs->min == 0);
         }
     } else {
         // More than one argument. They must all be non-positional
@@ -144,6 +235,21 @@ argument::argument(params::for_argument p_) {
                 "All of .names must be flag-like strings or a single positional argument name"};
         }
     }
+
+    // Move the strings into the pool, and release the originals
+    impl.pool = std::move(pool);
+    for (auto& name : impl.params.names) {
+        impl.names.push_back(impl.pool->intern(name, detail::pooled_kind::name));
+    }
+    impl.params.names = string_vec{};
+    if (impl.params.metavar) {
+        impl.metavar = impl.pool->intern(*impl.params.metavar, detail::pooled_kind::text);
+        impl.params.metavar.reset();
+    }
+    if (impl.params.help) {
+        impl.help = impl.pool->intern(*impl.params.help, detail::pooled_kind::text);
+        impl.params.help.reset();
+    }
 }
 
 argument_id argument::id() const noexcept {
@@ -154,7 +260,7 @@ argument_id argument::id() const noexcept {
 }
 
 std::string_view argument::match_long(std::string_view word) const noexcept {
-    for (std::string_view name : _params().names) {
+    for (std::string_view name : names()) {
         if (word.starts_with(name)) {
             if (name == word or word[name.size()] == '=') {
                 return name;
@@ -167,7 +273,7 @@ std::string_view argument::match_long(std::string_view word) const noexcept {
 }
 
 std::string_view argument::match_short(std::string_view letters) const noexcept {
-    for (std::string_view name : _params().names) {
+    for (std::string_view name : names()) {
         if (name.starts_with('-') and name.size() >= 2 and name[1] != '-') {
             auto shrt = name.substr(1);
             if (letters.starts_with(shrt)) {
@@ -178,9 +284,36 @@ std::string_view argument::match_short(std::string_view letters) const noexcept
     return std::string_view{};
 }
 
-void argument::handle(std::string_view spelling, std::string_view value) const {
+void argument::handle(std::string_view spelling,
+                      std::string_view value,
+                      parse_target     target) const {
+    handle(spelling, value_span(&value, 1), target);
+}
+
+void argument::check_values(value_span values) const {
+    auto& choices = _params().choices;
+    if (choices and wants_value()) {
+        for (auto value : values) {
+            if (not choices->contains(value)) {
+                BOOST_LEAF_THROW_EXCEPTION(invalid_argument_value{std::string(value)},
+                                           e_valid_choices{choices->words()});
+            }
+        }
+    }
+}
+
+void argument::handle(std::string_view spelling, value_span values, parse_target target) const {
+    check_values(values);
     auto&& act = _params().action;
     if (act) {
-        act(spelling, value);
+        act(target, spelling, values);
     }
-}
\ No newline at end of file
+}
+bool argument::has_validator() const noexcept { return bool(_params().validate); }
+
+void argument::validate(std::string_view spelling, std::string_view value) const {
+    auto&& val = _params().validate;
+    if (val) {
+        val(spelling, value);
+    }
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "./argv.hpp"
+#include "./choice_set.hpp"
+#include "./error.hpp"
 
 #include <neo/assignable_box.hpp>
 #include <neo/declval.hpp>
@@ -8,9 +10,14 @@
 
 #include <any>
 #include <cinttypes>
+#include <concepts>
 #include <functional>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
 
 namespace debate {
@@ -31,17 +38,229 @@ constexpr auto advanced  = category::advanced;
 constexpr auto debugging = category::debugging;
 constexpr auto hidden    = category::hidden;
 
+/**
+ * @brief The object that context-relative actions store into during a single parse.
+ *
+ * A target is given for each parse in params::for_parse::target. Actions created with a member
+ * pointer (e.g. `store_string(&options::output)`) write into the target instead of a variable
+ * that is bound when the parser is defined, so one parser can be shared by any number of
+ * concurrent parses.
+ */
+class parse_target {
+    void*                 _ptr  = nullptr;
+    const std::type_info* _type = nullptr;
+
+public:
+    parse_target() = default;
+
+    template <typename T>
+    requires(not std::is_const_v<T> and not std::same_as<T, parse_target>)
+    parse_target(T& obj) noexcept
+        : _ptr(std::addressof(obj))
+        , _type(&typeid(T)) {}
+
+    /**
+     * @brief Get the target object
+     *
+     * @throws invalid_argument_params if there is no target, or it is not a T
+     */
+    template <typename T>
+    T& get() const {
+        if (_type == nullptr or *_type != typeid(T)) {
+            throw invalid_argument_params{
+                "A context-relative action requires a params::for_parse::target of its type"};
+        }
+        return *static_cast<T*>(_ptr);
+    }
+};
+
+/// A batch of values for one occurrence of an argument. The views refer into the argv array.
+using value_span = std::span<const std::string_view>;
+
+/**
+ * @brief The action of an argument or subcommand.
+ *
+ * Created from a callable that takes the argument spelling and then either a single value or a
+ * value_span. A context-relative callable takes the parse_target before the spelling.
+ *
+ * A single-value callable is invoked once for each value that is given, while a value_span
+ * callable is invoked once for each occurrence of the argument, with all of its values.
+ */
+class argument_action {
+    std::function<void(parse_target, std::string_view, value_span)> _fn;
+
+    template <typename F>
+    static constexpr bool takes_value = std::invocable<F&, std::string_view, std::string_view>;
+    template <typename F>
+    static constexpr bool takes_span = std::invocable<F&, std::string_view, value_span>;
+    template <typename F>
+    static constexpr bool takes_target_value
+        = std::invocable<F&, parse_target, std::string_view, std::string_view>;
+    template <typename F>
+    static constexpr bool takes_target_span
+        = std::invocable<F&, parse_target, std::string_view, value_span>;
+
+public:
+    argument_action() = default;
+
+    template <typename F, typename D = std::remove_cvref_t<F>>
+    requires(not std::same_as<D, argument_action>
+             and (takes_value<D> or takes_span<D> or takes_target_value<D>
+                  or takes_target_span<D>))
+    argument_action(F&& fn) {
+        if constexpr (std::is_constructible_v<bool, const D&>) {
+            // An empty std::function (or a null function pointer) is no action at all
+            if (not static_cast<bool>(fn)) {
+                return;
+            }
+        }
+        // A callable that accepts either form (e.g. a generic lambda) takes single values
+        if constexpr (takes_value<D>) {
+            _fn = [fn = NEO_FWD(fn)](parse_target,
+                                     std::string_view spell,
+                                     value_span       values) mutable {
+                for (auto value : values) {
+                    fn(spell, value);
+                }
+            };
+        } else if constexpr (takes_span<D>) {
+            _fn = [fn = NEO_FWD(fn)](parse_target,
+                                     std::string_view spell,
+                                     value_span       values) mutable { fn(spell, values); };
+        } else if constexpr (takes_target_value<D>) {
+            _fn = [fn = NEO_FWD(fn)](parse_target     target,
+                                     std::string_view spell,
+                                     value_span       values) mutable {
+                for (auto value : values) {
+                    fn(target, spell, value);
+                }
+            };
+        } else {
+            _fn = NEO_FWD(fn);
+        }
+    }
+
+    explicit operator bool() const noexcept { return static_cast<bool>(_fn); }
+
+    void operator()(parse_target target, std::string_view spell, value_span values) const {
+        _fn(target, spell, values);
+    }
+    void operator()(parse_target target, std::string_view spell, std::string_view value) const {
+        _fn(target, spell, value_span(&value, 1));
+    }
+};
+
+/**
+ * @brief The number of values that an argument takes each time it is given.
+ *
+ * Constructed from a fixed count, or from one of the characters used by Python's argparse:
+ * '?' (zero or one), '*' (zero or more), or '+' (one or more).
+ */
+struct value_count {
+    std::size_t min = 1;
+    std::size_t max = 1;
+
+    static constexpr std::size_t unlimited = static_cast<std::size_t>(-1);
+
+    template <std::integral I>
+    requires(not std::same_as<I, char>)
+    constexpr value_count(I n)
+        : min(static_cast<std::size_t>(n))
+        , max(static_cast<std::size_t>(n)) {
+        if (n < 1) {
+            throw invalid_argument_params{"A fixed value_count must be at least one"};
+        }
+    }
+
+    /// A count between `min` and `max` values (inclusive)
+    constexpr value_count(std::size_t min_, std::size_t max_)
+        : min(min_)
+        , max(max_) {
+        if (max < 1 or min > max) {
+            throw invalid_argument_params{"Invalid range for a value_count"};
+        }
+    }
+
+    constexpr value_count(char c) {
+        switch (c) {
+        case '?':
+            min = 0;
+            max = 1;
+            return;
+        case '*':
+            min = 0;
+            max = unlimited;
+            return;
+        case '+':
+            min = 1;
+            max = unlimited;
+            return;
+        default:
+            throw invalid_argument_params{"A value_count must be one of '?', '*', or '+'"};
+        }
+    }
+};
+
+/**
+ * @brief The value that an argument receives when it is not given on the command line or in a
+ * config file.
+ *
+ * Either a literal value, or a callable that computes the value. A callable is only invoked when
+ * the default is actually used, so an expensive default costs nothing when the argument is given.
+ */
+class argument_default {
+    std::string                  _literal;
+    std::function<std::string()> _compute;
+
+public:
+    template <typename S>
+    requires std::convertible_to<S, std::string_view>
+    argument_default(S&& literal)
+        : _literal(std::string_view(literal)) {}
+
+    template <typename F, typename D = std::remove_cvref_t<F>>
+    requires(not std::convertible_to<F, std::string_view> and std::invocable<D&>
+             and std::convertible_to<std::invoke_result_t<D&>, std::string>)
+    argument_default(F&& fn)
+        : _compute(NEO_FWD(fn)) {}
+
+    /// The literal value, or nothing if the value is computed
+    std::optional<std::string_view> literal() const noexcept {
+        if (_compute) {
+            return std::nullopt;
+        }
+        return _literal;
+    }
+
+    /// Get the value, computing it if necessary
+    std::string value() const { return _compute ? _compute() : _literal; }
+};
+
 namespace params {
 
 struct for_argument {
     string_vec names;
 
-    std::function<void(std::string_view, std::string_view)> action;
+    argument_action action;
+
+    /// Checks a value after `action` has been invoked. May run concurrently with the rest of the
+    /// parse if an executor is given in params::for_parse.
+    std::function<void(std::string_view, std::string_view)> validate{};
 
     bool     can_repeat  = false;
     opt_bool required    = std::nullopt;
     bool     wants_value = true;
 
+    /// If given, the value must be one of these words
+    std::optional<choice_set> choices = std::nullopt;
+
+    /// If given, each occurrence of the argument takes this many values from the following words
+    std::optional<value_count> nargs = std::nullopt;
+    /// If given, each value word is also split at this character (e.g. "--list=a,b,c")
+    std::optional<char> delimiter = std::nullopt;
+    /// If given, the value to give the argument after parsing if it was not given at all
+    std::optional<argument_default> default_value = std::nullopt;
+
     opt_string metavar = std::nullopt;
     opt_string help    = std::nullopt;
 
@@ -53,6 +272,7 @@ struct for_argument {
 namespace detail {
 
 struct argument_data;
+class string_pool;
 
 }  // namespace detail
 
@@ -63,11 +283,37 @@ struct argument_id {
     constexpr auto operator<=>(const argument_id&) const noexcept = default;
 };
 
+/**
+ * @brief An estimate of the memory used by a parser tree, in bytes.
+ *
+ * See argument_parser::memory_usage()
+ */
+struct memory_report {
+    /// Argument and subcommand names
+    std::size_t names = 0;
+    /// Help text, metavars, descriptions, and epilogs
+    std::size_t help_text = 0;
+    /// The argument objects themselves
+    std::size_t arguments = 0;
+    /// Argument actions and validators (not counting state that they allocate themselves)
+    std::size_t actions = 0;
+    /// Name lookup tables, choice tables, constraint masks, and string pool bookkeeping
+    std::size_t indexes = 0;
+    /// Parser objects and subcommand tables
+    std::size_t subparsers = 0;
+
+    std::size_t total() const noexcept {
+        return names + help_text + arguments + actions + indexes + subparsers;
+    }
+};
+
 class argument : neo::shared_state<argument, detail::argument_data> {
     const params::for_argument& _params() const noexcept;
 
 public:
     explicit argument(params::for_argument p);
+    /// Create an argument that keeps its names and help text in the given pool
+    argument(params::for_argument p, std::shared_ptr<detail::string_pool> pool);
 
     bool is_positional() const noexcept;
 
@@ -75,16 +321,37 @@ public:
     bool          can_repeat() const noexcept;
     bool          is_required() const noexcept;
     bool          wants_value() const noexcept;
+    std::optional<value_count> nargs() const noexcept;
+    std::optional<char>        delimiter() const noexcept;
+    const std::optional<argument_default>& default_value() const noexcept;
     std::string   value_name() const noexcept;
     std::string   syntax_string() const noexcept;
     std::string   help_string() const noexcept;
     enum category category() const noexcept;
 
-    std::string_view preferred_name() const noexcept;
-    std::string_view match_long(std::string_view) const noexcept;
-    std::string_view match_short(std::string_view) const noexcept;
-
-    void handle(std::string_view argv_spelling, std::string_view argv_value) const;
+    std::span<const std::string_view> names() const noexcept;
+    std::optional<std::string_view>   metavar() const noexcept;
+    std::optional<std::string_view>   help() const noexcept;
+
+    const std::optional<choice_set>& choices() const noexcept;
+    std::string_view  preferred_name() const noexcept;
+    std::string_view  match_long(std::string_view) const noexcept;
+    std::string_view  match_short(std::string_view) const noexcept;
+
+    void handle(std::string_view argv_spelling,
+                std::string_view argv_value,
+                parse_target     target = {}) const;
+    /// Handle one occurrence of the argument that was given with the given values
+    void handle(std::string_view argv_spelling, value_span values, parse_target target = {}) const;
+    /// Check the values of one occurrence against the argument's choices, without invoking its
+    /// action
+    void check_values(value_span values) const;
+
+    bool has_validator() const noexcept;
+    void validate(std::string_view argv_spelling, std::string_view argv_value) const;
+
+    /// Add the memory used by this argument, excluding its pooled strings, to the report
+    void add_memory_usage(memory_report& report) const noexcept;
 };
 
 /// Error data: The argument object that was being handled that generated the error
@@ -102,6 +369,11 @@ struct e_argument_value {
     std::string value;
 };
 
+/// Error data: The words that would have been accepted for an argument with choices
+struct e_valid_choices {
+    std::vector<std::string> value;
+};
+
 template <typename Target, typename Value>
 concept storage_target = requires(Target&& t, Value&& v) {
     t = NEO_FWD(v);
@@ -111,7 +383,12 @@ template <storage_target<std::string> D>
 auto store_string(D&& out) noexcept {
     return [out = neo::assignable_box{NEO_FWD(out)}](std::string_view,
                                                      std::string_view spell) mutable {
-        out.get() = std::string(spell);
+        if constexpr (storage_target<D, std::string_view>) {
+            // Assign in place, so that a string target can reuse its existing capacity
+            out.get() = spell;
+        } else {
+            out.get() = std::string(spell);
+        }
     };
 }
 
@@ -134,6 +411,46 @@ auto store_false(B&& out) noexcept {
     return store_value(NEO_FWD(out), false);
 }
 
+/**
+ * Context-relative store actions: the destination is a member of the object that is given as
+ * params::for_parse::target, rather than a variable that is bound when the parser is defined.
+ */
+
+template <typename Ctx, typename M>
+requires storage_target<M&, std::string>
+auto store_string(M Ctx::*member) noexcept {
+    return [member](parse_target target, std::string_view, std::string_view spell) {
+        auto& out = target.get<Ctx>().*member;
+        if constexpr (storage_target<M&, std::string_view>) {
+            out = spell;
+        } else {
+            out = std::string(spell);
+        }
+    };
+}
+
+template <typename Ctx, typename M, typename T>
+requires storage_target<M&, T>
+auto store_value(M Ctx::*member, T&& value) noexcept {
+    return [member, value = NEO_FWD(value)](parse_target target,
+                                            std::string_view,
+                                            std::string_view) {
+        target.get<Ctx>().*member = value;
+    };
+}
+
+template <typename Ctx, typename M>
+requires storage_target<M&, bool>
+auto store_true(M Ctx::*member) noexcept {
+    return store_value(member, true);
+}
+
+template <typename Ctx, typename M>
+requires storage_target<M&, bool>
+auto store_false(M Ctx::*member) noexcept {
+    return store_value(member, false);
+}
+
 struct null_action_t {
     void operator()(std::string_view, std::string_view) const noexcept {}
 };
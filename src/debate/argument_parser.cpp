@@ -1,5 +1,8 @@
 #include "./argument_parser.hpp"
 
+#include "./detail/edit_distance.hpp"
+#include "./detail/memory_usage.hpp"
+#include "./detail/parser_impl.hpp"
 #include "./detail/reflow.hpp"
 #include "./error.hpp"
 
@@ -13,9 +16,16 @@
 #include <neo/utility.hpp>
 
 #include <algorithm>
+#include <bit>
+#include <condition_variable>
+#include <deque>
+#include <memory_resource>
+#include <exception>
 #include <map>
+#include <mutex>
 #include <ranges>
 #include <set>
+#include <span>
 
 using namespace std::literals;
 using namespace debate;
@@ -35,57 +45,628 @@ struct nocopy {
     nocopy(const nocopy&) = delete;
 };
 
-struct subparser {
-    category        cat;
-    argument_parser parser;
-};
+}  // namespace
+
+using detail::parser_map;
+using detail::subparser;
+using detail::subparser_group_impl;
 
-using parser_map = std::map<std::string, subparser, std::less<>>;
+/**
+ * The working storage of a parse. The vectors are cleared at the start of each parse but keep
+ * their capacity, so a parse_context that is reused stops allocating once it has warmed up. All
+ * of the storage is allocated from a single memory resource.
+ */
+struct detail::parse_context_data {
+    explicit parse_context_data(std::pmr::memory_resource* mr) noexcept
+        : memory(mr) {}
 
-struct subparser_group_impl {
-    parser_map  parsers;
-    std::string title;
-    opt_string  description;
-    bool        required;
+    /// The resource that all of the storage below is allocated from
+    std::pmr::memory_resource* memory;
+
+    /// Views of the words being parsed
+    std::pmr::vector<strv> words{memory};
+    /// The parser and the chain of selected subparsers
+    std::pmr::vector<argument_parser> parser_chain{memory};
+    /// Indices into parser_chain of the parsers that have any positional arguments
+    std::pmr::vector<std::size_t> positional_depths{memory};
+    /// For each entry of positional_depths, the index into the parser's positionals of the first
+    /// one that can still take a value. Positionals before it are never considered again.
+    std::pmr::vector<std::size_t> positional_cursors{memory};
+    /// The subcommand names that selected each parser in the chain after the first
+    std::pmr::vector<strv> subcommand_path{memory};
+    /// One bit for each argument of each parser in the chain, set once the argument is seen
+    std::pmr::vector<std::uint64_t> seen_bits{memory};
+    /// The index of the first bit in seen_bits for each parser in the chain
+    std::pmr::vector<std::size_t> seen_offsets{memory};
+    /// An argument group that is attached to a parser in the chain
+    struct chain_group {
+        const detail::argument_parser_impl* group;
+        /// The first bit in seen_bits for the arguments of the group
+        std::size_t first_bit;
+        /// The depth and table index of the first parser in the chain that has the group
+        std::size_t depth;
+        std::size_t table;
+    };
+    /// The distinct argument groups of the parsers in the chain
+    std::pmr::vector<chain_group> chain_groups{memory};
+    /// The index into chain_groups of each group of each parser in the chain
+    std::pmr::vector<std::size_t> group_indices{memory};
+    /// For each parser in the chain, the index of its first entry in group_indices
+    std::pmr::vector<std::size_t> group_starts{memory};
+    /// For each parser in the chain, two bitmasks over its constraints: The constraints that have
+    /// been satisfied, then the constraints that have been triggered
+    std::pmr::vector<std::uint64_t> constraint_bits{memory};
+    /// The index of the first word in constraint_bits for each parser in the chain
+    std::pmr::vector<std::size_t> constraint_offsets{memory};
+    /// Indices and categories of the help-request words in `words`
+    std::pmr::vector<std::pair<std::size_t, category>> help_words{memory};
+    /// The values of the current argument after splitting them at its delimiter
+    std::pmr::vector<strv> split_values{memory};
+    /// The default values that were applied. Validators may still refer to them, so a deque
+    /// keeps each one in place.
+    std::pmr::deque<std::pmr::string> default_values{memory};
 
-    std::weak_ptr<detail::argument_parser_impl> parent;
+    // State for incremental parsing. The chain of an incremental parse is kept in checkpoint_chain
+    // after the parse, and the chain of each checkpoint is a prefix of it.
 
-    std::function<void(std::string_view, std::string_view)> action;
+    struct checkpoint {
+        /// The index of the next word to be parsed
+        std::size_t word;
+        /// The index after the last word that was examined to reach this state. (Values with a
+        /// value_count may look ahead at one more word, or to the end of the words.)
+        std::size_t lookahead_end;
+        std::size_t chain_size;
+        /// The range of checkpoint_bits that holds seen_bits, followed by constraint_bits
+        std::size_t bits_offset;
+        std::size_t n_seen_words;
+        std::size_t n_constraint_words;
+    };
+    std::pmr::vector<checkpoint>      checkpoints{memory};
+    std::pmr::vector<std::uint64_t>   checkpoint_bits{memory};
+    std::pmr::vector<argument_parser> checkpoint_chain{memory};
+    /// The subcommand names that selected the parsers of checkpoint_chain after the first
+    std::pmr::vector<strv> checkpoint_path{memory};
+    /// The words of the previous incremental parse
+    std::pmr::vector<std::pmr::string> prev_words{memory};
+    /// The root parser of the previous incremental parse
+    const detail::argument_parser_impl* prev_root = nullptr;
+    std::size_t                         resumed_at = 0;
+    /// The number of name tables, positional arguments and help words examined by the parse
+    std::size_t probes = 0;
 };
 
-}  // namespace
+namespace {
+
+using word_span  = std::span<const strv>;
+using word_range = stdr::subrange<word_span::iterator>;
 
-struct detail::argument_parser_impl {
-    params::for_argument_parser params;
+/// An argument, along with its position within the parser chain
+struct arg_ref {
+    const argument* arg;
+    /// The index of the owning parser in the parser chain
+    std::size_t depth;
+    /// The ordinal of the argument within its parser (including attached groups)
+    std::size_t ordinal;
+    /// The bit in parse_context_data::seen_bits that tracks the argument
+    std::size_t seen_bit;
+};
 
-    std::string                         name;
-    std::weak_ptr<argument_parser_impl> parent;
+/// An argument validator that was started on the executor
+struct pending_validation {
+    arg_ref            ref;
+    strv               spelling;
+    strv               value;
+    std::ptrdiff_t     word_index = -1;
+    std::exception_ptr error{};
+};
 
-    /// Command-line arguments attached to this parser
-    std::vector<debate::argument> arguments{};
-    /// Sub-parsers attached to this parser. Only non-null after a call to add_subparsers()
-    std::optional<subparser_group_impl> subparsers{};
+/// Tracks the validators that are running on the executor, so that they can be joined
+class validation_group {
+    // Held by pointer so that running tasks can refer to their entry while more are added
+    std::vector<std::unique_ptr<pending_validation>> _pending;
 
-    // nocopy _disable_copy{};
+    std::mutex              _mutex;
+    std::condition_variable _cv;
+    std::size_t             _n_running = 0;
 
-    static argument_parser_impl&       extract(argument_parser& p) noexcept { return *p._impl; }
-    static const argument_parser_impl& extract(const argument_parser& p) noexcept {
-        return *p._impl;
+    void _finish() {
+        std::lock_guard lk{_mutex};
+        --_n_running;
+        _cv.notify_all();
     }
-};
 
-namespace {
+public:
+    void start(const std::function<void(std::function<void()>)>& executor,
+               pending_validation                                v) {
+        auto& entry = *_pending.emplace_back(std::make_unique<pending_validation>(v));
+        {
+            std::lock_guard lk{_mutex};
+            ++_n_running;
+        }
+        try {
+            executor([this, &entry] {
+                try {
+                    entry.ref.arg->validate(entry.spelling, entry.value);
+                } catch (...) {
+                    entry.error = std::current_exception();
+                }
+                _finish();
+            });
+        } catch (...) {
+            _finish();
+            throw;
+        }
+    }
+
+    /// Wait for every validator that has been started to complete
+    void wait() noexcept {
+        std::unique_lock lk{_mutex};
+        _cv.wait(lk, [&] { return _n_running == 0; });
+    }
+
+    /// The validators in the order they were started. Only valid after wait().
+    const auto& results() const noexcept { return _pending; }
+};
 
 struct parsing_state {
-    explicit parsing_state(argument_parser n)
-        : parser_chain({n}) {}
+    static const auto& _impl_of(const auto& parser) {
+        return detail::argument_parser_impl::extract(parser);
+    }
+
+    explicit parsing_state(argument_parser             n,
+                           const params::for_parse&    p,
+                           detail::parse_context_data& d)
+        : data(d)
+        , observer(p.observer)
+        , config(p.config)
+        , target(p.target)
+        , incremental(p.incremental)
+        , remainder(p.remainder)
+        , run_actions(p.run_actions)
+        , diagnostics(p.diagnostics)
+        , summary(p.summary)
+        , executor(p.executor) {
+        reset_state();
+        enter_parser(std::move(n));
+        data.resumed_at = 0;
+        data.probes     = 0;
+    }
+
+    ~parsing_state() {
+        // Validators may still be running if the parse is failing
+        validations.wait();
+        if (incremental) {
+            // The next incremental parse may need to restore the parsers of this one
+            std::swap(data.checkpoint_chain, parser_chain);
+            std::swap(data.checkpoint_path, subcommand_path);
+        }
+        // Do not keep the parsers (or views of the caller's words) alive between parses
+        parser_chain.clear();
+        data.words.clear();
+    }
+
+    void reset_state() noexcept {
+        parser_chain.clear();
+        positional_depths.clear();
+        data.positional_cursors.clear();
+        subcommand_path.clear();
+        data.seen_bits.clear();
+        data.seen_offsets.clear();
+        data.constraint_bits.clear();
+        data.constraint_offsets.clear();
+        data.chain_groups.clear();
+        data.group_indices.clear();
+        data.group_starts.clear();
+        n_seen_bits = 0;
+    }
+
+    detail::parse_context_data& data;
+
+    std::pmr::vector<argument_parser>& parser_chain      = data.parser_chain;
+    std::pmr::vector<std::size_t>&     positional_depths = data.positional_depths;
+    std::pmr::vector<strv>&            subcommand_path   = data.subcommand_path;
+
+    parse_observer*    observer = nullptr;
+    const config_file* config   = nullptr;
+    parse_target       target{};
+    bool               incremental = false;
+    parse_remainder*   remainder   = nullptr;
+    bool               run_actions = true;
+    std::vector<parse_diagnostic>* diagnostics = nullptr;
+    parse_summary*                 summary     = nullptr;
+    /// The index of the word being parsed, or -1 once all of the words have been parsed
+    std::ptrdiff_t current_word = -1;
+    /// The number of words taken by the argument of the current word, once it is known. Used to
+    /// skip its values after an error.
+    int words_taken = 1;
+    word_span          all_words{};
+    /// The index after the last word that was examined so far (see checkpoint::lookahead_end)
+    std::size_t lookahead = 0;
+
+    /// A copy, so that it does not depend on the lifetime of the caller's params
+    std::function<void(std::function<void()>)> executor;
+    validation_group                           validations{};
+
+    /// The number of bits of seen_bits that are in use
+    std::size_t n_seen_bits = 0;
+    /// Whether data.help_words has been computed for this parse
+    bool help_scanned = false;
 
-    std::vector<argument_parser> parser_chain;
+    /// Append a parser to the chain
+    void enter_parser(argument_parser parser) {
+        auto& impl = _impl_of(parser);
+        data.seen_offsets.push_back(n_seen_bits);
+        n_seen_bits += impl.arguments.size();
+        data.group_starts.push_back(data.group_indices.size());
+        for (std::size_t t = 1; t < impl.n_tables(); ++t) {
+            // A group's arguments are tracked once, no matter how many parsers it is attached to
+            auto grp   = &impl.table(t);
+            auto known = stdr::find(data.chain_groups, grp, NEO_TL(_1.group));
+            if (known == data.chain_groups.end()) {
+                data.chain_groups.push_back({grp, n_seen_bits, parser_chain.size(), t});
+                n_seen_bits += grp->arguments.size();
+                known = data.chain_groups.end() - 1;
+            }
+            data.group_indices.push_back(
+                static_cast<std::size_t>(known - data.chain_groups.begin()));
+        }
+        data.seen_bits.resize((n_seen_bits + 63) / 64, 0);
+        data.constraint_offsets.push_back(data.constraint_bits.size());
+        data.constraint_bits.resize(data.constraint_bits.size() + 2 * impl.constraint_words, 0);
+        if (not impl.positionals.empty()) {
+            positional_depths.push_back(parser_chain.size());
+            data.positional_cursors.push_back(0);
+        }
+        parser_chain.push_back(std::move(parser));
+    }
+
+    /// Refer to an argument in one of the argument tables of the parser at the given depth
+    arg_ref table_ref(std::size_t depth, std::size_t table, std::size_t idx) const noexcept {
+        auto& impl      = _impl_of(parser_chain[depth]);
+        auto  first_bit = data.seen_offsets[depth];
+        if (table != 0) {
+            auto group_idx = data.group_indices[data.group_starts[depth] + table - 1];
+            first_bit      = data.chain_groups[group_idx].first_bit;
+        }
+        return arg_ref{
+            .arg      = &impl.table(table).arguments[idx],
+            .depth    = depth,
+            .ordinal  = impl.table_base(table) + idx,
+            .seen_bit = first_bit + idx,
+        };
+    }
+
+    /// Refer to one of the parser's own arguments
+    arg_ref own_ref(std::size_t depth, std::size_t ordinal) const noexcept {
+        return table_ref(depth, 0, ordinal);
+    }
+
+    bool was_seen(arg_ref ref) const noexcept {
+        auto bit = ref.seen_bit;
+        return ((data.seen_bits[bit / 64] >> (bit % 64)) & 1u) != 0;
+    }
+
+    void mark_seen(arg_ref ref) {
+        auto  bit  = ref.seen_bit;
+        auto& word = data.seen_bits[bit / 64];
+        auto  flag = std::uint64_t{1} << (bit % 64);
+        if ((word & flag) == 0) {
+            word |= flag;
+            apply_constraints(ref);
+        }
+    }
+
+    /// The satisfied and triggered constraint bitmasks for the parser at the given depth
+    std::pair<std::span<std::uint64_t>, std::span<std::uint64_t>>
+    constraint_state(std::size_t depth) noexcept {
+        auto n_words = _impl_of(parser_chain[depth]).constraint_words;
+        auto state   = std::span(data.constraint_bits).subspan(data.constraint_offsets[depth]);
+        return {state.first(n_words), state.subspan(n_words, n_words)};
+    }
+
+    /// Update the constraint state for an argument that has been given for the first time
+    void apply_constraints(arg_ref ref) {
+        auto& impl = _impl_of(parser_chain[ref.depth]);
+        if (ref.ordinal >= impl.n_constrained) {
+            return;
+        }
+        auto [satisfied, triggered] = constraint_state(ref.depth);
+        auto satisfies              = impl.masks_of(ref.ordinal, impl.satisfies);
+        auto excludes               = impl.masks_of(ref.ordinal, impl.excludes);
+        auto triggers               = impl.masks_of(ref.ordinal, impl.triggers);
+        for (std::size_t idx = 0; idx < satisfied.size(); ++idx) {
+            if (auto clash = satisfied[idx] & excludes[idx]) {
+                raise_conflict(ref, idx * 64 + static_cast<std::size_t>(std::countr_zero(clash)));
+            }
+            satisfied[idx] |= satisfies[idx];
+            triggered[idx] |= triggers[idx];
+        }
+    }
 
-    std::set<argument_id> seen{};
+    [[noreturn]] void raise_conflict(arg_ref ref, std::size_t constraint_idx) const {
+        auto& impl = _impl_of(parser_chain[ref.depth]);
+        auto& con  = impl.constraints[constraint_idx];
+        ON_ERROR([&] { return e_constraint{con.def}; });
+        for (auto ordinal : con.ordinals) {
+            if (ordinal != ref.ordinal and was_seen(own_ref(ref.depth, ordinal))) {
+                ON_ERROR(e_conflicting_argument{impl.arguments[ordinal]});
+                BOOST_LEAF_THROW_EXCEPTION(
+                    conflicting_arguments{std::string(ref.arg->preferred_name())});
+            }
+        }
+        neo_assert(invariant,
+                   false,
+                   "Constraint conflict without a conflicting argument",
+                   constraint_idx);
+        std::terminate();
+    }
+
+    /// Raise an error for the first unmet constraint of the parser at the given depth, if any
+    void check_constraints(std::size_t depth) {
+        auto& impl                  = _impl_of(parser_chain[depth]);
+        auto [satisfied, triggered] = constraint_state(depth);
+        for (std::size_t idx = 0; idx < satisfied.size(); ++idx) {
+            auto unmet = (impl.required_constraints[idx] | triggered[idx]) & ~satisfied[idx];
+            if (unmet == 0) {
+                continue;
+            }
+            auto  bit = idx * 64 + static_cast<std::size_t>(std::countr_zero(unmet));
+            auto& con = impl.constraints[bit];
+            ON_ERROR([&] { return e_constraint{con.def}; });
+            if (con.def.kind == constraint_kind::dependency) {
+                // The prerequisite is missing
+                const argument& prereq = impl.arguments[con.ordinals.back()];
+                ON_ERROR(e_argument{prereq});
+                BOOST_LEAF_THROW_EXCEPTION(missing_argument{std::string(prereq.preferred_name())});
+            }
+            std::string names;
+            for (auto ordinal : con.ordinals) {
+                names.append(names.empty() ? "" : " / ");
+                names.append(impl.arguments[ordinal].preferred_name());
+            }
+            BOOST_LEAF_THROW_EXCEPTION(missing_argument{names});
+        }
+    }
 
-    void check_help(argv_subrange remaining) {
-        static std::map<std::string_view, category> help_map = {
+    /// Invoke the action of an argument, then start its validator (if it has one) for each value
+    void bind(arg_ref ref, strv spelling, value_span values) {
+        if (run_actions) {
+            ref.arg->handle(spelling, values, target);
+        } else {
+            ref.arg->check_values(values);
+        }
+        if (not ref.arg->has_validator()) {
+            return;
+        }
+        for (auto value : values) {
+            if (executor) {
+                validations.start(executor,
+                                  {
+                                      .ref        = ref,
+                                      .spelling   = spelling,
+                                      .value      = value,
+                                      .word_index = current_word,
+                                  });
+            } else {
+                ref.arg->validate(spelling, value);
+            }
+        }
+    }
+
+    void bind(arg_ref ref, strv spelling, strv value) {
+        bind(ref, spelling, value_span(&value, 1));
+    }
+
+    /// Split the value words of an argument at its delimiter, if it has one
+    value_span split_values(const argument& arg, value_span words) {
+        auto delim = arg.delimiter();
+        if (not delim) {
+            return words;
+        }
+        auto& out = data.split_values;
+        out.clear();
+        for (strv word : words) {
+            // string_view::find() is a memchr(), which the C library vectorizes for long values
+            for (auto pos = word.find(*delim); pos != strv::npos; pos = word.find(*delim)) {
+                out.push_back(word.substr(0, pos));
+                word.remove_prefix(pos + 1);
+            }
+            out.push_back(word);
+        }
+        return out;
+    }
+
+    /// Bind the value words that were given with one occurrence of an argument
+    void bind_words(word_range argv, strv spelling, arg_ref ref, value_span words) {
+        auto values = split_values(*ref.arg, words);
+        for (auto value : values) {
+            notify_bound(argv, spelling, value, ref);
+        }
+        bind(ref, spelling, values);
+    }
+
+    static bool looks_like_negative_number(strv word) noexcept {
+        auto digit_at = [&](std::size_t i) {
+            return i < word.size() and word[i] >= '0' and word[i] <= '9';
+        };
+        return word.starts_with('-') and (digit_at(1) or (word[1] == '.' and digit_at(2)));
+    }
+
+    /// Whether any parser in the chain has a short option that looks like a negative number
+    bool have_numeric_options() const noexcept {
+        for (auto& parser : parser_chain) {
+            auto& impl = _impl_of(parser);
+            for (std::size_t t = 0; t < impl.n_tables(); ++t) {
+                auto& names = impl.table(t).short_names;
+                auto  found = names.lower_bound('0');
+                if (found != names.end() and found->first <= '9') {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /// As in argparse, "-1" is a value unless the parsers have options that look like numbers
+    bool looks_like_option(strv word) const noexcept {
+        if (word.size() < 2 or not word.starts_with('-')) {
+            return false;
+        }
+        return not looks_like_negative_number(word) or have_numeric_options();
+    }
+
+    /**
+     * @brief Bind the values of an argument that has a value_count, taken from the words of
+     * `argv` after the first `skip`. Values end at the first word that looks like an option,
+     * which does not include negative numbers (see looks_like_option()).
+     *
+     * @return The number of words that were taken
+     */
+    int bind_nargs(word_range argv, std::size_t skip, strv spelling, arg_ref ref) {
+        auto        count = *ref.arg->nargs();
+        auto        words = word_span(argv.begin(), argv.end()).subspan(skip);
+        std::size_t n     = 0;
+        while (n < count.max and n < words.size() and not looks_like_option(words[n])) {
+            ++n;
+        }
+        if (n < count.max) {
+            // The values were ended by the next word, or by the end of the words
+            auto first = static_cast<std::size_t>(index_of(argv)) + skip;
+            lookahead  = std::max(lookahead, n < words.size() ? first + n + 1 : strv::npos);
+        }
+        words_taken = static_cast<int>(std::max<std::size_t>(1, skip + n));
+        if (n < count.min) {
+            check_help(argv);
+            throw missing_argument_value{std::string(spelling)};
+        }
+        ON_ERROR([&] { return e_argument_value{n ? std::string(words[0]) : ""}; });
+        bind_words(argv, spelling, ref, words.first(n));
+        return static_cast<int>(n);
+    }
+
+    /// Bind the single value word of an argument that was given as "--name=value" or "-nvalue"
+    void bind_attached(word_range argv, strv spelling, arg_ref ref, strv value) {
+        if (ref.arg->nargs() and ref.arg->nargs()->min > 1) {
+            check_help(argv);
+            throw missing_argument_value{std::string(spelling)};
+        }
+        ON_ERROR([&] { return e_argument_value{std::string(value)}; });
+        bind_words(argv, spelling, ref, value_span(&value, 1));
+    }
+
+    /// Wait for the validators on the executor, and raise the first failure (in argv order)
+    void join_validations() {
+        validations.wait();
+        for (auto& entry : validations.results()) {
+            if (not entry->error) {
+                continue;
+            }
+            ON_ERROR(e_argument_parser{parser_chain[entry->ref.depth]});
+            ON_ERROR(e_argument{*entry->ref.arg});
+            ON_ERROR([&] { return e_argument_name{std::string(entry->spelling)}; });
+            ON_ERROR([&] { return e_argument_value{std::string(entry->value)}; });
+            // The failing value may be before a checkpoint, so a resumed parse would miss it
+            data.checkpoints.clear();
+            current_word = entry->word_index;
+            recover([&] { std::rethrow_exception(entry->error); });
+        }
+        current_word = -1;
+    }
+
+    /**
+     * @brief Run the given function. If diagnostics are being collected, an error about the
+     * command line is recorded (for the current word) instead of being thrown.
+     *
+     * @return Whether the function completed without an error
+     */
+    template <typename Func>
+    bool recover(Func&& fn) {
+        if (not diagnostics) {
+            fn();
+            return true;
+        }
+        try {
+            fn();
+            return true;
+        } catch (const runtime_error& err) {
+            notify([&] {
+                return parse_event{
+                    .kind         = parse_event_kind::error_raised,
+                    .word_index   = current_word,
+                    .word         = current_word < 0 ? strv{} : all_words[current_word],
+                    .parser_depth = parser_chain.size() - 1,
+                    .error        = &err,
+                };
+            });
+            diagnostics->push_back({
+                .word_index = current_word,
+                .error      = std::current_exception(),
+                .message    = err.what(),
+            });
+            return false;
+        }
+    }
+
+    /**
+     * @brief Emit a parse event to the attached observer, if any.
+     *
+     * The event is only constructed if there is an observer present, so that tracing costs a
+     * single branch when it is not in use.
+     */
+    template <typename MakeEvent>
+    void notify(MakeEvent&& make_event) const {
+        if (observer) [[unlikely]] {
+            observer->on_event(make_event());
+        }
+    }
+
+    std::ptrdiff_t index_of(word_range argv) const noexcept {
+        return std::distance(all_words.begin(), argv.begin());
+    }
+
+    void notify_bound(word_range argv, strv spelling, strv value, arg_ref ref) {
+        record_binding(index_of(argv), value, ref);
+        notify([&] {
+            return parse_event{
+                .kind           = parse_event_kind::value_bound,
+                .word_index     = index_of(argv),
+                .word           = argv.front(),
+                .spelling       = spelling,
+                .value          = value,
+                .parser_depth   = ref.depth,
+                .arg            = ref.arg,
+                .argument_index = ref.ordinal,
+            };
+        });
+    }
+
+    void record_binding(std::ptrdiff_t word_index, strv value, arg_ref ref) {
+        if (summary) {
+            summary->bindings.push_back({
+                .parser_depth   = ref.depth,
+                .argument_index = ref.ordinal,
+                .word_index     = word_index,
+                .value          = value,
+            });
+        }
+    }
+
+    void notify_matched(word_range argv, strv spelling, arg_ref ref) const {
+        notify([&] {
+            return parse_event{
+                .kind           = parse_event_kind::argument_matched,
+                .word_index     = index_of(argv),
+                .word           = argv.front(),
+                .spelling       = spelling,
+                .parser_depth   = ref.depth,
+                .arg            = ref.arg,
+                .argument_index = ref.ordinal,
+            };
+        });
+    }
+
+    void check_help(word_range remaining) {
+        static const std::map<std::string_view, category> help_map = {
             {"--help", general},
             {"-help", general},
             {"-h", general},
@@ -96,61 +677,472 @@ struct parsing_state {
             {"--help-debug", debugging},
             {"--help-all", debugging},
         };
-        auto is_help_request = [](auto s) { return help_map.contains(s); };
-        auto help_arg        = stdr::find_if(remaining, is_help_request);
-        if (help_arg != remaining.end()) {
-            category cat = help_map.find(*help_arg)->second;
-            throw help_request{cat};
+        auto& help_words = data.help_words;
+        if (not help_scanned) {
+            // Scan the whole array once, so that repeated checks do not rescan it
+            help_scanned = true;
+            help_words.clear();
+            for (std::size_t idx = 0; idx < all_words.size(); ++idx) {
+                ++data.probes;
+                auto help_arg = help_map.find(all_words[idx]);
+                if (help_arg != help_map.end()) {
+                    help_words.emplace_back(idx, help_arg->second);
+                } else if (is_help_search(all_words[idx])) {
+                    help_words.emplace_back(idx, general);
+                }
+            }
+        }
+        auto first_idx  = static_cast<std::size_t>(index_of(remaining));
+        auto first_help = stdr::lower_bound(help_words, first_idx, std::less<>{}, NEO_TL(_1.first));
+        if (first_help != help_words.end()
+            and first_help->first < first_idx + remaining.size()) {
+            if (is_help_search(all_words[first_help->first])) {
+                throw help_search_request{help_search_terms(first_help->first)};
+            }
+            throw help_request{first_help->second};
         }
     }
 
-    void parse_args(const argv_array& args) {
-        ON_ERROR(e_argv_array{args});
-        argv_subrange argv{args.begin(), args.end()};
+    /// Whether the word is `--help-search`, with or without attached search terms
+    static bool is_help_search(strv word) noexcept {
+        return word == "--help-search" or word.starts_with("--help-search=");
+    }
 
-        while (not argv.empty()) {
-            int n_skip = parse_more(argv);
-            argv       = argv.next(n_skip);
+    /// The search terms given to the `--help-search` at the index: its attached value, followed
+    /// by every word after it
+    std::string help_search_terms(std::size_t idx) {
+        auto        word = all_words[idx];
+        std::string terms;
+        if (word.starts_with("--help-search=")) {
+            terms = word.substr(14);
         }
+        for (auto rest : all_words.subspan(idx + 1)) {
+            ++data.probes;
+            terms.append(terms.empty() ? "" : " ").append(rest);
+        }
+        return terms;
+    }
 
-        finalize();
+    /// Suggest argument names from the parser chain that are similar to the given flag
+    e_did_you_mean suggest_names(strv given) const {
+        std::vector<strv> candidates;
+        for (const auto& parser : parser_chain) {
+            auto& impl = _impl_of(parser);
+            for (std::size_t t = 0; t < impl.n_tables(); ++t) {
+                for (const argument& arg : impl.table(t).arguments) {
+                    if (arg.is_positional() or arg.category() == hidden) {
+                        continue;
+                    }
+                    candidates.insert(candidates.end(), arg.names().begin(), arg.names().end());
+                }
+            }
+        }
+        auto name = given.substr(0, given.find('='));
+        return e_did_you_mean{detail::rank_suggestions(name, candidates)};
     }
 
-    static const auto& _impl_of(const auto& parser) {
-        return detail::argument_parser_impl::extract(parser);
+    /// Suggest subcommand names from the tail parser that are similar to the given word
+    e_did_you_mean suggest_subcommands(strv given) const {
+        std::vector<strv> candidates;
+        for (auto& [name, sub] : _impl_of(parser_chain.back()).subparsers->parsers) {
+            if (sub.cat != hidden) {
+                candidates.push_back(name);
+            }
+        }
+        return e_did_you_mean{detail::rank_suggestions(given, candidates)};
+    }
+
+    void parse_args(word_span words) {
+        // The owning copy of the words is only made if an error actually occurs
+        ON_ERROR([&] { return e_argv_array{argv_array{words}}; });
+        all_words = words;
+        word_range argv{words.begin(), words.end()};
+        if (incremental) {
+            argv = argv.next(static_cast<std::ptrdiff_t>(resume(words)));
+        }
+        if (remainder) {
+            // The words before a checkpoint were already sorted by the previous parse
+            std::erase_if(remainder->indices, NEO_TL(_1 >= data.resumed_at));
+        }
+        auto resumed = static_cast<std::ptrdiff_t>(data.resumed_at);
+        if (diagnostics) {
+            std::erase_if(*diagnostics, NEO_TL(_1.word_index < 0 or _1.word_index >= resumed));
+        }
+        if (summary) {
+            std::erase_if(summary->bindings,
+                          NEO_TL(_1.word_index < 0 or _1.word_index >= resumed));
+            summary->subcommand_path.clear();
+        }
+
+        try {
+            while (not argv.empty()) {
+                // After an error, continue after the words that the failing argument took, so
+                // that its values are not parsed again as arguments of their own
+                int n_skip   = 1;
+                words_taken  = 1;
+                current_word = index_of(argv);
+                if (not recover([&] { n_skip = parse_more(argv); })) {
+                    n_skip = words_taken;
+                }
+                argv = argv.next(n_skip);
+                if (incremental) {
+                    record_checkpoint(static_cast<std::size_t>(index_of(argv)));
+                }
+            }
+            current_word = -1;
+            if (summary) {
+                summary->subcommand_path.assign(subcommand_path.begin(), subcommand_path.end());
+            }
+
+            if (config) {
+                recover([&] { apply_config(*config); });
+            }
+            finalize();
+        } catch (const std::exception& err) {
+            notify([&] {
+                return parse_event{
+                    .kind         = parse_event_kind::error_raised,
+                    .word_index   = argv.empty() ? -1 : index_of(argv),
+                    .word         = argv.empty() ? strv{} : strv{argv.front()},
+                    .parser_depth = parser_chain.size() - 1,
+                    .error        = &err,
+                };
+            });
+            throw;
+        }
     }
 
-    auto chain_arguments() const {
-        return parser_chain                                          //
-            | std::views::transform(NEO_TL(_impl_of(_1).arguments))  //
-            | std::views::join;
+    void record_checkpoint(std::size_t word) {
+        auto& bits = data.checkpoint_bits;
+        data.checkpoints.push_back({
+            .word               = word,
+            .lookahead_end      = std::max(word, lookahead),
+            .chain_size         = parser_chain.size(),
+            .bits_offset        = bits.size(),
+            .n_seen_words       = data.seen_bits.size(),
+            .n_constraint_words = data.constraint_bits.size(),
+        });
+        bits.insert(bits.end(), data.seen_bits.begin(), data.seen_bits.end());
+        bits.insert(bits.end(), data.constraint_bits.begin(), data.constraint_bits.end());
     }
 
-    void finalize() const {
-        for (const auto& parser : parser_chain) {
+    /**
+     * @brief Restore the last checkpoint that does not depend on a word that has changed since the
+     * previous incremental parse, and remember the new words.
+     *
+     * @return The index of the first word that still needs to be parsed
+     */
+    std::size_t resume(word_span words) {
+        auto&       prev = data.prev_words;
+        std::size_t same = 0;
+        while (same < words.size() and same < prev.size() and words[same] == prev[same]) {
+            ++same;
+        }
+        if (same == words.size() and same == prev.size()) {
+            // Nothing has changed, not even the number of words
+            same = strv::npos;
+        } else {
+            prev.resize(words.size());
+            for (auto idx = same; idx < words.size(); ++idx) {
+                prev[idx].assign(words[idx]);
+            }
+        }
+
+        auto root = &_impl_of(parser_chain.front());
+        if (data.prev_root != root) {
+            data.checkpoints.clear();
+            data.prev_root = root;
+        }
+        auto& cps = data.checkpoints;
+        while (not cps.empty() and cps.back().lookahead_end > same) {
+            cps.pop_back();
+        }
+        if (cps.empty()) {
+            data.checkpoint_bits.clear();
+            return 0;
+        }
+
+        auto& cp = cps.back();
+        data.checkpoint_bits.resize(cp.bits_offset + cp.n_seen_words + cp.n_constraint_words);
+        reset_state();
+        for (std::size_t depth = 0; depth < cp.chain_size; ++depth) {
+            if (depth != 0) {
+                subcommand_path.push_back(data.checkpoint_path[depth - 1]);
+            }
+            enter_parser(data.checkpoint_chain[depth]);
+        }
+        auto bits = std::span(data.checkpoint_bits).subspan(cp.bits_offset);
+        stdr::copy(bits.first(cp.n_seen_words), data.seen_bits.begin());
+        stdr::copy(bits.subspan(cp.n_seen_words), data.constraint_bits.begin());
+        data.resumed_at = cp.word;
+        return cp.word;
+    }
+
+    /**
+     * @brief Find the depth in the parser chain for the given config section.
+     *
+     * @return The depth, or nullopt if the section names a valid subparser that is not part of
+     * the chain (i.e. its subcommand was not selected).
+     */
+    std::optional<std::size_t> section_depth(strv section) const {
+        std::size_t depth    = 0;
+        auto        impl     = &_impl_of(parser_chain.front());
+        bool        in_chain = true;
+        while (not section.empty()) {
+            auto dot  = section.find('.');
+            auto part = neo::trim(section.substr(0, dot));
+            section.remove_prefix(dot == strv::npos ? section.size() : dot + 1);
+
+            auto child = impl->subparsers ? impl->subparsers->parsers.find(part)
+                                          : parser_map::const_iterator{};
+            if (not impl->subparsers or child == impl->subparsers->parsers.end()) {
+                BOOST_LEAF_THROW_EXCEPTION(invalid_config_syntax{"Unknown config section"},
+                                           e_argument_name{std::string(part)});
+            }
+            in_chain = in_chain and depth < subcommand_path.size()
+                and subcommand_path[depth] == part;
+            impl = &_impl_of(child->second.get());
+            ++depth;
+        }
+        if (not in_chain) {
+            return std::nullopt;
+        }
+        return depth;
+    }
+
+    /// Find the argument of the parser at the given depth that is named by a config key
+    std::optional<arg_ref>
+    find_config_argument(std::size_t depth, strv key, std::pmr::string& name_buf) const {
+        auto& impl      = _impl_of(parser_chain[depth]);
+        strv  long_name = key;
+        if (not key.starts_with("-")) {
+            name_buf.assign("--");
+            name_buf.append(key);
+            long_name = name_buf;
+        }
+        for (std::size_t t = 0; t < impl.n_tables(); ++t) {
+            auto& table = impl.table(t);
+            auto  found = table.long_names.find(long_name);
+            if (found != table.long_names.end()) {
+                return table_ref(depth, t, found->second);
+            }
+        }
+        for (auto ordinal : impl.positionals) {
+            if (impl.arguments[ordinal].preferred_name() == key) {
+                return own_ref(depth, ordinal);
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Apply settings from a config file to the arguments that were not already given on
+     * the command line.
+     *
+     * Arguments seen on the command line take precedence, and their config settings are skipped
+     * entirely. Otherwise, settings are applied with the same actions and the same repetition
+     * rules as command-line arguments.
+     */
+    void apply_config(const config_file& cfg) {
+        ON_ERROR(e_config_file{cfg.filepath()});
+        std::pmr::set<argument_id> from_config{data.memory};
+        std::pmr::string           name_buf{data.memory};
+
+        strv                       cached_section;
+        std::optional<std::size_t> cached_depth = section_depth(cached_section);
+        for (const config_entry& entry : cfg.entries()) {
+            ON_ERROR(e_config_line{entry.line});
+            if (entry.section != cached_section) {
+                cached_section = entry.section;
+                cached_depth   = section_depth(cached_section);
+            }
+            if (not cached_depth.has_value()) {
+                // This section is for a subcommand that was not selected
+                continue;
+            }
+            const auto& parser = parser_chain[*cached_depth];
+            ON_ERROR(e_argument_parser{parser});
+            auto found = find_config_argument(*cached_depth, entry.key, name_buf);
+            if (not found.has_value()) {
+                BOOST_LEAF_THROW_EXCEPTION(unknown_argument{std::string(entry.key)});
+            }
+            arg_ref         ref = *found;
+            const argument& arg = *ref.arg;
+            ON_ERROR(e_argument{arg});
+            ON_ERROR(e_argument_name{std::string(entry.key)});
+            ON_ERROR([&] { return e_argument_value{std::string(entry.value)}; });
+            if (was_seen(ref) and not from_config.count(arg.id())) {
+                // The command line takes precedence
+                continue;
+            }
+            if (from_config.count(arg.id()) and not arg.can_repeat()) {
+                BOOST_LEAF_THROW_EXCEPTION(
+                    invalid_argument_repetition{std::string(entry.key)});
+            }
+            strv value = entry.value;
+            if (not arg.wants_value() and not arg.is_positional()) {
+                if (value == "false" or value == "no" or value == "off" or value == "0") {
+                    continue;
+                }
+                if (value != "true" and value != "yes" and value != "on" and value != "1") {
+                    BOOST_LEAF_THROW_EXCEPTION(invalid_argument_value{std::string(value)});
+                }
+                value = "";
+            }
+            mark_seen(ref);
+            from_config.insert(arg.id());
+            auto spelling = arg.preferred_name();
+            record_binding(-1, value, ref);
+            notify([&] {
+                return parse_event{
+                    .kind           = parse_event_kind::value_bound,
+                    .word           = entry.key,
+                    .spelling       = spelling,
+                    .value          = value,
+                    .parser_depth   = ref.depth,
+                    .arg            = ref.arg,
+                    .argument_index = ref.ordinal,
+                };
+            });
+            bind(ref, spelling, split_values(arg, value_span(&value, 1)));
+        }
+    }
+
+    /// Give the default value to an argument that has one, if it was not given
+    void apply_default(arg_ref ref) {
+        const argument& arg = *ref.arg;
+        if (not arg.default_value() or was_seen(ref)) {
+            return;
+        }
+        ON_ERROR(e_argument{arg});
+        // A computed default is only computed now that it is needed
+        auto& value    = data.default_values.emplace_back(arg.default_value()->value());
+        auto  spelling = arg.preferred_name();
+        ON_ERROR([&] { return e_argument_value{std::string(value)}; });
+        notify([&] {
+            return parse_event{
+                .kind           = parse_event_kind::value_bound,
+                .spelling       = spelling,
+                .value          = value,
+                .parser_depth   = ref.depth,
+                .arg            = ref.arg,
+                .argument_index = ref.ordinal,
+            };
+        });
+        strv word = value;
+        bind(ref, spelling, split_values(arg, value_span(&word, 1)));
+    }
+
+    /**
+     * @brief Apply the defaults of the arguments that were not given. Defaults do not count as
+     * having given the argument, so they do not affect constraints.
+     */
+    void apply_defaults() {
+        data.default_values.clear();
+        for (std::size_t depth = 0; depth < parser_chain.size(); ++depth) {
+            ON_ERROR(e_argument_parser{parser_chain[depth]});
+            auto& args = _impl_of(parser_chain[depth]).arguments;
+            for (std::size_t ordinal = 0; ordinal < args.size(); ++ordinal) {
+                recover([&] { apply_default(own_ref(depth, ordinal)); });
+            }
+        }
+        for (auto& grp : data.chain_groups) {
+            ON_ERROR(e_argument_parser{parser_chain[grp.depth]});
+            for (std::size_t idx = 0; idx < grp.group->arguments.size(); ++idx) {
+                recover([&] { apply_default(table_ref(grp.depth, grp.table, idx)); });
+            }
+        }
+    }
+
+    void finalize() {
+        if (run_actions) {
+            apply_defaults();
+        }
+        join_validations();
+        for (std::size_t depth = 0; depth < parser_chain.size(); ++depth) {
+            const auto& parser = parser_chain[depth];
+            ON_ERROR(e_argument_parser{parser});
+            auto& args = _impl_of(parser).arguments;
+            for (std::size_t ordinal = 0; ordinal < args.size(); ++ordinal) {
+                const argument& arg = args[ordinal];
+                if (not arg.is_required()) {
+                    continue;
+                }
+                auto ref = own_ref(depth, ordinal);
+                notify([&] {
+                    return parse_event{
+                        .kind           = parse_event_kind::finalize_check,
+                        .parser_depth   = ref.depth,
+                        .arg            = ref.arg,
+                        .argument_index = ref.ordinal,
+                    };
+                });
+                if (not was_seen(ref)) {
+                    recover([&] {
+                        ON_ERROR(e_argument{arg});
+                        BOOST_LEAF_THROW_EXCEPTION(
+                            missing_argument{std::string(arg.preferred_name())});
+                    });
+                }
+            }
+            recover([&] { check_constraints(depth); });
+        }
+
+        // Attached groups are checked once, for the first parser in the chain that has them
+        for (auto& grp : data.chain_groups) {
+            const auto& parser = parser_chain[grp.depth];
             ON_ERROR(e_argument_parser{parser});
-            for (const argument& arg : _impl_of(parser).arguments) {
-                if (arg.is_required() and not seen.count(arg.id())) {
-                    ON_ERROR(e_argument{arg});
-                    BOOST_LEAF_THROW_EXCEPTION(missing_argument{std::string(arg.preferred_name())});
+            for (std::size_t idx = 0; idx < grp.group->arguments.size(); ++idx) {
+                auto ref = table_ref(grp.depth, grp.table, idx);
+                if (not ref.arg->is_required()) {
+                    continue;
+                }
+                notify([&] {
+                    return parse_event{
+                        .kind           = parse_event_kind::finalize_check,
+                        .parser_depth   = ref.depth,
+                        .arg            = ref.arg,
+                        .argument_index = ref.ordinal,
+                    };
+                });
+                if (not was_seen(ref)) {
+                    recover([&] {
+                        ON_ERROR(e_argument{*ref.arg});
+                        BOOST_LEAF_THROW_EXCEPTION(
+                            missing_argument{std::string(ref.arg->preferred_name())});
+                    });
                 }
             }
         }
 
         if (_impl_of(parser_chain.back()).subparsers
             and _impl_of(parser_chain.back()).subparsers->required) {
-            ON_ERROR(e_argument_parser{parser_chain.back()});
-            BOOST_LEAF_THROW_EXCEPTION(
-                missing_argument{std::string(_impl_of(parser_chain.back()).subparsers->title)});
+            recover([&] {
+                ON_ERROR(e_argument_parser{parser_chain.back()});
+                BOOST_LEAF_THROW_EXCEPTION(missing_argument{
+                    std::string(_impl_of(parser_chain.back()).subparsers->title)});
+            });
         }
     }
 
-    int parse_more(argv_subrange argv) {
+    int parse_more(word_range argv) {
         strv current = argv.front();
-        ON_ERROR(e_parsing_word{std::string(current)});
-        auto _ = boost::leaf::on_error(e_parsing_word{std::string(current)},
-                                       e_argument_parser{parser_chain.back()});
-        if (current.starts_with("--")) {
+        // Copying the word is deferred until an error actually occurs
+        ON_ERROR([&] { return e_parsing_word{std::string(current)}; });
+        ON_ERROR(e_argument_parser{parser_chain.back()});
+        notify([&] {
+            return parse_event{
+                .kind         = parse_event_kind::word_lexed,
+                .word_index   = index_of(argv),
+                .word         = current,
+                .parser_depth = parser_chain.size() - 1,
+            };
+        });
+        if (remainder and current == "--") {
+            // Everything after the separator is left for another program
+            skip_to_remainder(argv.next(1), argv.size() - 1);
+            return static_cast<int>(argv.size());
+        } else if (current.starts_with("--")) {
             // A long option
             return try_parse_long(current, argv);
         } else if (current.starts_with("-")) {
@@ -160,51 +1152,93 @@ struct parsing_state {
         }
     }
 
-    int try_parse_long(strv given, argv_subrange argv) {
+    int try_parse_long(strv given, word_range argv) {
         ON_ERROR(e_argument_parser(parser_chain.back()));
-        for (auto parser : std::views::reverse(parser_chain)) {
+        auto name = given.substr(0, given.find('='));
+        for (auto depth = parser_chain.size(); depth-- > 0;) {
+            const auto& parser = parser_chain[depth];
             ON_ERROR(e_argument_parser{parser});
-            for (const argument& arg : _impl_of(parser).arguments) {
-                ON_ERROR(e_argument{arg});
-                auto match = arg.match_long(given);
-                if (match.empty()) {
+            auto& impl = _impl_of(parser);
+            // The parser's own arguments, then those of its attached groups
+            for (std::size_t t = 0; t < impl.n_tables(); ++t) {
+                ++data.probes;
+                auto& table = impl.table(t);
+                auto  found = table.long_names.find(name);
+                if (found == table.long_names.end()) {
                     continue;
                 }
-                ON_ERROR(e_argument_name{std::string(match)});
-                return handle_long(given, match, arg, argv);
+                auto ref = table_ref(depth, t, found->second);
+                ON_ERROR(e_argument{*ref.arg});
+                ON_ERROR([&] { return e_argument_name{std::string(found->first)}; });
+                return handle_long(given, found->first, ref, argv);
             }
         }
+        if (remainder) {
+            return skip_unknown(argv);
+        }
         check_help(argv);
+        ON_ERROR([&] { return suggest_names(given); });
         BOOST_LEAF_THROW_EXCEPTION(unknown_argument{std::string{given}});
     }
 
-    int handle_long(strv given, strv arg_name, const argument& arg, argv_subrange argv) {
-        if (seen.count(arg.id())) {
+    /// Put the first `n` words of `argv` into the remainder
+    void skip_to_remainder(word_range argv, std::size_t n) {
+        auto first = static_cast<std::size_t>(index_of(argv));
+        for (std::size_t idx = 0; idx < n; ++idx) {
+            remainder->indices.push_back(first + idx);
+            notify([&] {
+                return parse_event{
+                    .kind         = parse_event_kind::word_skipped,
+                    .word_index   = static_cast<std::ptrdiff_t>(first + idx),
+                    .word         = argv[static_cast<std::ptrdiff_t>(idx)],
+                    .parser_depth = parser_chain.size() - 1,
+                };
+            });
+        }
+    }
+
+    /// Put an unrecognized word into the remainder, along with the rest of the words if the
+    /// remainder is set to stop there. Returns the number of words that were skipped.
+    int skip_unknown(word_range argv) {
+        auto n = remainder->mode == parse_remainder::stop_at_unknown ? argv.size() : 1;
+        skip_to_remainder(argv, n);
+        return static_cast<int>(n);
+    }
+
+    int handle_long(strv given, strv arg_name, arg_ref ref, word_range argv) {
+        const argument& arg = *ref.arg;
+        if (was_seen(ref)) {
             // We've already seen this argument before
             if (not arg.can_repeat()) {
                 check_help(argv);
                 BOOST_LEAF_THROW_EXCEPTION(invalid_argument_repetition{std::string(arg_name)});
             }
         }
-        seen.insert(arg.id());
+        mark_seen(ref);
+        notify_matched(argv, arg_name, ref);
         auto tail = given.substr(arg_name.size());
         if (tail.empty()) {
             // The next in the argv would be the value
             if (not arg.wants_value()) {
                 // This is an argument without a value
                 ON_ERROR(e_argument_value{""});
-                arg.handle(arg_name, "");
+                notify_bound(argv, arg_name, "", ref);
+                bind(ref, arg_name, "");
                 return 1;
             }
+            if (arg.nargs()) {
+                return 1 + bind_nargs(argv, 1, arg_name, ref);
+            }
             // Treat the next argv element as the value
             auto it = argv.begin() + 1;
             if (it == argv.end()) {
                 check_help(argv);
                 throw missing_argument_value{std::string{arg_name}};
             }
-            auto value = *it;
-            ON_ERROR(e_argument_value{value});
-            arg.handle(arg_name, value);
+            strv value  = *it;
+            words_taken = 2;
+            ON_ERROR([&] { return e_argument_value{std::string(value)}; });
+            bind_words(argv, arg_name, ref, value_span(&value, 1));
             return 2;
         } else {
             // The given argv element is spelled as "--long-option=something"
@@ -218,9 +1252,7 @@ struct parsing_state {
                 check_help(argv);
                 throw invalid_argument_value{std::string(tail.substr(1))};
             }
-            auto value = tail.substr(1);
-            ON_ERROR(e_argument_value{std::string(value)});
-            arg.handle(arg_name, value);
+            bind_attached(argv, arg_name, ref, tail.substr(1));
             return 1;
         }
     }
@@ -230,7 +1262,8 @@ struct parsing_state {
         int n_words;
     };
 
-    int try_parse_shorts(strv letters, argv_subrange argv) {
+    int try_parse_shorts(strv letters, word_range argv) {
+        const auto n_letters = letters.size();
         while (not letters.empty()) {
             short_skip_results skip = try_parse_shorts_1(letters, argv);
             letters.remove_prefix(skip.n_letters);
@@ -240,86 +1273,121 @@ struct parsing_state {
             }
             if (skip.n_letters == 0) {
                 // We never matched anything
+                if (remainder and letters.size() == n_letters) {
+                    // Nothing in the word was known, so it can be left for another program
+                    return skip_unknown(argv);
+                }
                 check_help(argv);
-                throw unknown_argument{"-" + std::string(letters)};
+                auto word = "-" + std::string(letters);
+                ON_ERROR([&] { return suggest_names(word); });
+                throw unknown_argument{word};
             }
         }
         return 1;
     }
 
-    short_skip_results try_parse_shorts_1(strv letters, argv_subrange argv) {
-        for (const auto& parser : std::views::reverse(parser_chain)) {
+    short_skip_results try_parse_shorts_1(strv letters, word_range argv) {
+        for (auto depth = parser_chain.size(); depth-- > 0;) {
+            const auto& parser = parser_chain[depth];
             ON_ERROR(e_argument_parser{parser});
-            for (auto&& arg : _impl_of(parser).arguments) {
-                ON_ERROR(e_argument{arg});
-                auto mat = arg.match_short(letters);
-                if (mat.empty()) {
-                    continue;
+            auto& impl = _impl_of(parser);
+            for (std::size_t t = 0; t < impl.n_tables(); ++t) {
+                // Only the short names that begin with the same letter can possibly match
+                auto [first, last] = impl.table(t).short_names.equal_range(letters.front());
+                ++data.probes;
+                for (const auto& [_, entry] : stdr::subrange(first, last)) {
+                    ++data.probes;
+                    if (not letters.starts_with(entry.name.substr(1))) {
+                        continue;
+                    }
+                    auto ref = table_ref(depth, t, entry.ordinal);
+                    ON_ERROR(e_argument{*ref.arg});
+                    return handle_short(letters, entry.name, ref, argv);
                 }
-                return handle_short(letters, mat, arg, argv);
             }
         }
         return short_skip_results{0, 0};
     }
 
     short_skip_results
-    handle_short(strv letters, strv short_name, const argument& arg, argv_subrange argv) {
-        std::string with_hyphen = "-" + std::string(short_name);
-        ON_ERROR(e_argument_name{with_hyphen});
-        if (seen.count(arg.id())) {
+    handle_short(strv letters, strv with_hyphen, arg_ref ref, word_range argv) {
+        const argument& arg        = *ref.arg;
+        auto            short_name = with_hyphen.substr(1);
+        ON_ERROR([&] { return e_argument_name{std::string(with_hyphen)}; });
+        if (was_seen(ref)) {
             // We've seen this one before
             if (not arg.can_repeat()) {
                 check_help(argv);
-                throw invalid_argument_repetition{with_hyphen};
+                throw invalid_argument_repetition{std::string(with_hyphen)};
             }
         }
-        seen.insert(arg.id());
+        mark_seen(ref);
+        notify_matched(argv, with_hyphen, ref);
         auto remain = letters.substr(short_name.size());
         if (arg.wants_value()) {
-            if (remain.empty()) {
+            if (remain.empty() and arg.nargs()) {
+                auto n_values = bind_nargs(argv, 1, with_hyphen, ref);
+                return short_skip_results{.n_letters = static_cast<int>(short_name.size()),
+                                          .n_words   = 1 + n_values};
+            } else if (remain.empty()) {
                 // Treat the following word as the value
                 auto it = argv.begin() + 1;
                 if (it == argv.end()) {
                     check_help(argv);
-                    throw missing_argument_value{with_hyphen};
+                    throw missing_argument_value{std::string(with_hyphen)};
                 }
-                ON_ERROR(e_argument_value{*it});
-                arg.handle(with_hyphen, *it);
+                strv value  = *it;
+                words_taken = 2;
+                ON_ERROR([&] { return e_argument_value{std::string(value)}; });
+                bind_words(argv, with_hyphen, ref, value_span(&value, 1));
                 return short_skip_results{.n_letters = static_cast<int>(short_name.size()),
                                           .n_words   = 2};
             } else {
                 // Treat the remainder of the word as the argument
-                ON_ERROR(e_argument_value{std::string(remain)});
-                arg.handle(with_hyphen, remain);
+                bind_attached(argv, with_hyphen, ref, remain);
                 return short_skip_results{.n_letters = static_cast<int>(letters.size()),
                                           .n_words   = 1};
             }
         } else {
             // No value. Ignore remaining letters
             ON_ERROR(e_argument_value{""});
-            arg.handle(with_hyphen, "");
+            notify_bound(argv, with_hyphen, "", ref);
+            bind(ref, with_hyphen, "");
             return short_skip_results{.n_letters = static_cast<int>(short_name.size()),
                                       .n_words   = 0};
         }
     }
 
-    int try_parse_positional(strv given, argv_subrange argv) {
-        for (auto parser : std::views::reverse(parser_chain)) {
+    int try_parse_positional(strv given, word_range argv) {
+        // Only visit the parsers that have any positional arguments at all, so that a deep chain
+        // of subparsers is not rescanned for every word.
+        for (auto idx = positional_depths.size(); idx-- > 0;) {
+            auto        depth  = positional_depths[idx];
+            const auto& parser = parser_chain[depth];
             ON_ERROR(e_argument_parser{parser});
-            for (auto&& arg : _impl_of(parser).arguments) {
-                ON_ERROR(e_argument{arg});
-                if (not arg.is_positional()) {
-                    // We're not parsing these here
-                    continue;
-                }
-                ON_ERROR(e_argument_name{std::string(arg.preferred_name())});
-                if (seen.count(arg.id()) and not arg.can_repeat()) {
+            auto& impl = _impl_of(parser);
+            // Positionals are only ever marked as seen, so the ones that are already satisfied
+            // can be skipped for good, and a repeatable positional is found in constant time.
+            auto& cursor = data.positional_cursors[idx];
+            for (; cursor < impl.positionals.size(); ++cursor) {
+                ++data.probes;
+                auto            ordinal = impl.positionals[cursor];
+                const argument& arg     = impl.arguments[ordinal];
+                auto            ref     = own_ref(depth, ordinal);
+                if (was_seen(ref) and not arg.can_repeat()) {
                     // We've already seen this one
                     continue;
                 }
-                seen.insert(arg.id());
-                ON_ERROR(e_argument_value{std::string(given)});
-                arg.handle(given, given);
+                ON_ERROR(e_argument{arg});
+                ON_ERROR([&] { return e_argument_name{std::string(arg.preferred_name())}; });
+                mark_seen(ref);
+                notify_matched(argv, arg.preferred_name(), ref);
+                if (arg.nargs()) {
+                    // The given word is the first value
+                    return bind_nargs(argv, 0, given, ref);
+                }
+                ON_ERROR([&] { return e_argument_value{std::string(given)}; });
+                bind_words(argv, given, ref, value_span(&given, 1));
                 return 1;
             }
         }
@@ -327,19 +1395,34 @@ struct parsing_state {
         // No positional argument matched. Maybe a subcommand?
         detail::argument_parser_impl const& tail_parser = _impl_of(parser_chain.back());
         if (tail_parser.subparsers.has_value()) {
+            ++data.probes;
             auto child = tail_parser.subparsers->parsers.find(given);
             if (child != tail_parser.subparsers->parsers.end()) {
                 // We found a subparser!
-                if (tail_parser.subparsers->action) {
-                    tail_parser.subparsers->action(given, given);
+                if (run_actions and tail_parser.subparsers->action) {
+                    tail_parser.subparsers->action(target, given, given);
                 }
-                parser_chain.push_back(child->second.parser);
+                enter_parser(child->second.get());
+                subcommand_path.push_back(child->first);
+                notify([&] {
+                    return parse_event{
+                        .kind         = parse_event_kind::subparser_entered,
+                        .word_index   = index_of(argv),
+                        .word         = given,
+                        .spelling     = child->first,
+                        .parser_depth = parser_chain.size() - 1,
+                    };
+                });
                 return 1;
-            } else {
+            } else if (not remainder) {
                 check_help(argv);
+                ON_ERROR([&] { return suggest_subcommands(given); });
                 throw invalid_argument_value{std::string{given}};
             }
         }
+        if (remainder) {
+            return skip_unknown(argv);
+        }
         check_help(argv);
         throw unknown_argument{std::string{given}};
     }
@@ -351,15 +1434,68 @@ argument_parser::argument_parser() noexcept
     : argument_parser(params::for_argument_parser{}) {}
 
 argument_parser::argument_parser(params::for_argument_parser p) {
-    _impl = neo::copy_shared(detail::argument_parser_impl{
-        .params = std::move(p),
-        .name   = "",
-        .parent = {},
-    });
+    _impl = detail::argument_parser_impl::create(std::move(p));
 }
 
 argument argument_parser::add_argument(params::for_argument p) {
-    return _impl->arguments.emplace_back(std::move(p));
+    auto& arg = _impl->arguments.emplace_back(std::move(p), _impl->pool());
+    _impl->index_argument(_impl->arguments.size() - 1);
+    return arg;
+}
+
+void argument_parser::add_constraint(params::for_constraint p) {
+    std::pmr::vector<std::size_t> ordinals{_impl->memory()};
+    for (const argument& arg : p.arguments) {
+        auto found = stdr::find(_impl->arguments, arg.id(), &argument::id);
+        if (found == _impl->arguments.end()) {
+            throw invalid_argument_params{
+                "Constrained arguments must belong to the parser that has the constraint"};
+        }
+        ordinals.push_back(static_cast<std::size_t>(found - _impl->arguments.begin()));
+    }
+    if (ordinals.size() < 2) {
+        throw invalid_argument_params{"A constraint must refer to at least two arguments"};
+    }
+    if (p.kind == constraint_kind::dependency) {
+        for (std::size_t idx = 1; idx < ordinals.size(); ++idx) {
+            if (ordinals[idx] == ordinals.front()) {
+                throw invalid_argument_params{"An argument cannot depend on itself"};
+            }
+            _impl->constraints.push_back(detail::constraint_impl{
+                .def      = {.kind      = p.kind,
+                             .arguments = {p.arguments.front(), p.arguments[idx]}},
+                .ordinals = std::pmr::vector<std::size_t>({ordinals.front(), ordinals[idx]},
+                                                          _impl->memory()),
+            });
+        }
+    } else {
+        _impl->constraints.push_back(
+            detail::constraint_impl{.def = std::move(p), .ordinals = std::move(ordinals)});
+    }
+    _impl->rebuild_constraint_masks();
+}
+
+void argument_parser::add_group(const argument_group& group) {
+    if (stdr::find(_impl->groups, group._impl) != _impl->groups.end()) {
+        throw invalid_argument_params{"The argument group is already attached to this parser"};
+    }
+    _impl->groups.push_back(group._impl);
+}
+
+argument_group::argument_group()
+    : argument_group(nullptr) {}
+
+argument_group::argument_group(std::pmr::memory_resource* memory)
+    : _impl(detail::argument_parser_impl::create({.memory = memory})) {}
+
+argument argument_group::add_argument(params::for_argument p) {
+    argument arg{std::move(p), _impl->pool()};
+    if (arg.is_positional()) {
+        throw invalid_argument_params{"An argument group cannot have positional arguments"};
+    }
+    _impl->arguments.push_back(arg);
+    _impl->index_argument(_impl->arguments.size() - 1);
+    return arg;
 }
 
 subparser_group argument_parser::add_subparsers(params::for_subparser_group p) {
@@ -368,7 +1504,7 @@ subparser_group argument_parser::add_subparsers(params::for_subparser_group p) {
             "Cannot have multiple subparser groups attached to a single parent parser"};
     }
     _impl->subparsers = subparser_group_impl{
-        .parsers     = {},
+        .parsers     = detail::parser_map{_impl->memory()},
         .title       = p.title,
         .description = p.description,
         .required    = p.required.value_or(true),
@@ -383,7 +1519,7 @@ subparser_group::subparser_group(argument_parser p) noexcept
 
 argument_parser subparser_group::add_parser(params::for_subparser p) {
     auto& impl  = detail::argument_parser_impl::extract(_parser);
-    auto  found = impl.subparsers->parsers.find(p.name);
+    auto  found = impl.subparsers->parsers.find(strv(p.name));
     if (found != impl.subparsers->parsers.end()) {
         throw invalid_argument_params{"Duplicate subparser name"};
     }
@@ -391,30 +1527,61 @@ argument_parser subparser_group::add_parser(params::for_subparser p) {
         .prog        = p.name,
         .description = p.description,
         .epilog      = p.epilog,
+        .memory      = impl.params.memory,
     });
     subparser       child{.cat = p.category, .parser = parser};
     impl.subparsers->parsers.emplace(p.name, child);
-    parser._impl->parent = _parser._impl;
+    // The whole tree keeps its strings in one pool
+    parser._impl->parent  = _parser._impl;
+    parser._impl->strings = impl.pool();
     return parser;
 }
 
-void argument_parser::_parse_args(argv_array argv) const {
+parse_context::parse_context(std::pmr::memory_resource* memory)
+    : _data(std::make_unique<detail::parse_context_data>(memory)) {}
+
+parse_context::parse_context(parse_context&&) noexcept = default;
+parse_context& parse_context::operator=(parse_context&&) noexcept = default;
+parse_context::~parse_context()                                   = default;
+
+std::pmr::vector<std::string_view>& parse_context::_words() noexcept { return _data->words; }
+
+std::size_t parse_context::resumed_at() const noexcept { return _data->resumed_at; }
+
+std::size_t parse_context::probes() const noexcept { return _data->probes; }
+
+void parse_context::clear_checkpoints() noexcept {
+    _data->checkpoints.clear();
+    _data->checkpoint_chain.clear();
+    _data->checkpoint_path.clear();
+    _data->prev_root = nullptr;
+}
+
+void argument_parser::_parse_words(std::span<const std::string_view> words,
+                                   params::for_parse                 p) const {
     auto _ = boost::leaf::on_error(e_argument_parser{*this});
-    parsing_state{*this}.parse_args(argv);
+    if (p.context) {
+        parsing_state{*this, p, *p.context->_data}.parse_args(words);
+    } else {
+        detail::parse_context_data data{p.memory ? p.memory : std::pmr::get_default_resource()};
+        parsing_state{*this, p, data}.parse_args(words);
+    }
 }
 
-void argument_parser::parse_main_argv(int argc, const char* const* argv) const {
+void argument_parser::parse_main_argv(int                argc,
+                                      const char* const* argv,
+                                      params::for_parse  p) const {
     neo_assert_always(expects,
                       argc >= 1,
                       "At least one argument is required for parse_main_argv()",
                       argc);
-    auto       _ = boost::leaf::on_error(e_invoked_as{argv[0]});
-    argv_array arr{argv + 1, argv + argc};
-    _parse_args(std::move(arr));
+    auto _ = boost::leaf::on_error(e_invoked_as{argv[0]});
+    parse_args(std::span(argv + 1, argv + argc), p);
 }
 
 std::string argument_parser::arg_usage_string(category cat) const noexcept {
-    auto arg_syntaxes = _impl->arguments              //
+    auto all_args     = _impl->all_arguments();
+    auto arg_syntaxes = all_args                      //
         | stdv::filter(NEO_TL(_1.category() <= cat))  //
         | stdv::transform(&argument::syntax_string)   //
         | neo::join_text(" "sv);
@@ -447,8 +1614,9 @@ std::string argument_parser::usage_string(category cat, std::string_view prognam
     std::string subcommand_suffix;
     auto        tail_parser = _impl;
     while (tail_parser) {
+        auto tail_args = tail_parser->all_arguments();
         neo::ranges::input_range_of<argument> auto selected_args
-            = stdv::filter(tail_parser->arguments, NEO_TL(_1.category() <= cat));
+            = stdv::filter(tail_args, NEO_TL(_1.category() <= cat));
         for (const argument& arg : selected_args) {
             if (arg.is_required() and tail_parser != _impl) {
                 subcommand_suffix = neo::ufmt(" {}{}", arg.syntax_string(), subcommand_suffix);
@@ -487,8 +1655,9 @@ std::string argument_parser::help_string(category cat, std::string_view progname
     }
     bool any_required = false;
 
+    auto all_args = _impl->all_arguments();
     neo::ranges::input_range_of<argument> auto selected_args
-        = stdv::filter(_impl->arguments, NEO_TL(_1.category() <= cat));
+        = stdv::filter(all_args, NEO_TL(_1.category() <= cat));
 
     for (auto& arg : selected_args) {
         if (not arg.is_required()) {
@@ -530,7 +1699,7 @@ std::string argument_parser::help_string(category cat, std::string_view progname
             ret.append("\n");
         }
         for (auto& [key, sub] : subs.parsers | stdv::filter(NEO_TL(_1.second.cat <= cat))) {
-            argument_parser subp = sub.parser;
+            argument_parser subp = sub.get();
             std::string     usg  = subp.arg_usage_string(cat);
             ret.append(std::string(neo::str_concat("• ", key, " ", usg)));
             auto& desc = subp._impl->params.description;
@@ -543,8 +1712,8 @@ std::string argument_parser::help_string(category cat, std::string_view progname
     }
 
     auto any_of_category = [&](auto C) {
-        return stdr::any_of(_impl->arguments, [&](auto arg) { return arg.category() == C; })
-            or (_impl->subparsers and stdr::any_of(_impl->subparsers->parsers, [&](auto pair) {
+        return stdr::any_of(all_args, [&](auto arg) { return arg.category() == C; })
+            or (_impl->subparsers and stdr::any_of(_impl->subparsers->parsers, [&](auto& pair) {
                     return pair.second.cat == C;
                 }));
     };
@@ -572,3 +1741,88 @@ std::string argument_parser::help_string(category cat, std::string_view progname
     }
     return ret;
 }
+
+namespace {
+
+using detail::heap_bytes;
+
+std::size_t heap_bytes(const opt_string& s) noexcept { return s ? heap_bytes(*s) : 0; }
+
+/// An estimate of the memory used by a node-based container: each node holds a value and about
+/// four pointers (the links and the color or hash)
+template <typename Map>
+std::size_t node_bytes(const Map& m) noexcept {
+    return m.size() * (sizeof(typename Map::value_type) + 4 * sizeof(void*));
+}
+
+template <typename T, typename Alloc>
+std::size_t vector_bytes(const std::vector<T, Alloc>& v) noexcept {
+    return v.capacity() * sizeof(T);
+}
+
+struct memory_walker {
+    memory_report report;
+    /// The string pools and argument groups that have already been counted
+    std::set<const void*> visited;
+
+    /// Count an argument table: a parser's own arguments, or those of a group
+    void add_table(const detail::argument_parser_impl& impl) {
+        report.arguments += vector_bytes(impl.arguments);
+        for (auto& arg : impl.arguments) {
+            arg.add_memory_usage(report);
+        }
+        report.indexes += node_bytes(impl.long_names) + node_bytes(impl.short_names)
+            + vector_bytes(impl.positionals) + vector_bytes(impl.constraints)
+            + vector_bytes(impl.required_constraints) + vector_bytes(impl.constraint_masks);
+        for (auto& con : impl.constraints) {
+            report.indexes += vector_bytes(con.def.arguments) + vector_bytes(con.ordinals);
+        }
+        if (impl.strings and visited.insert(impl.strings.get()).second) {
+            auto& pool = *impl.strings;
+            report.names += pool.bytes(detail::pooled_kind::name);
+            report.help_text += pool.bytes(detail::pooled_kind::text);
+            report.indexes += sizeof(pool) + pool.overhead_bytes();
+        }
+    }
+
+    void add_parser(const detail::argument_parser_impl& impl) {
+        // The shared state and its control block
+        report.subparsers += sizeof(impl) + 2 * sizeof(void*);
+        report.names += heap_bytes(impl.name);
+        report.help_text += heap_bytes(impl.params.prog) + heap_bytes(impl.params.description)
+            + heap_bytes(impl.params.epilog);
+        add_table(impl);
+
+        report.subparsers += vector_bytes(impl.groups);
+        for (auto& grp : impl.groups) {
+            if (visited.insert(grp.get()).second) {
+                report.subparsers += sizeof(*grp) + 2 * sizeof(void*);
+                add_table(*grp);
+            }
+        }
+
+        if (not impl.subparsers) {
+            return;
+        }
+        auto& grp = *impl.subparsers;
+        report.help_text += heap_bytes(grp.title) + heap_bytes(grp.description);
+        report.subparsers += node_bytes(grp.parsers);
+        for (auto& [name, sub] : grp.parsers) {
+            report.names += heap_bytes(name);
+            if (sub.lazy) {
+                report.subparsers += sizeof(*sub.lazy) + 2 * sizeof(void*);
+            }
+            if (auto loaded = sub.loaded()) {
+                add_parser(detail::argument_parser_impl::extract(*loaded));
+            }
+        }
+    }
+};
+
+}  // namespace
+
+memory_report argument_parser::memory_usage() const {
+    memory_walker walker;
+    walker.add_parser(*_impl);
+    return walker.report;
+}
@@ -2,16 +2,26 @@
 
 #include "./argument.hpp"
 #include "./argv.hpp"
+#include "./config_file.hpp"
+#include "./parse_observer.hpp"
 
 #include <memory>
+#include <memory_resource>
+#include <cstdint>
+#include <exception>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace debate {
 
 class argument_parser;
+class parse_context;
 
 using opt_string = std::optional<std::string>;
 
@@ -21,12 +31,105 @@ struct help_request : std::exception {
         : category{cat} {}
 };
 
+/**
+ * @brief Thrown when the words ask to search the help of the parser tree with
+ * `--help-search <terms>` (or `--help-search=<terms>`). The terms are every word after the
+ * option, joined by spaces. A help_index answers the search.
+ */
+struct help_search_request : std::exception {
+    std::string terms;
+    explicit help_search_request(std::string t) noexcept
+        : terms{std::move(t)} {}
+};
+
+/// The kind of rule enforced by an argument constraint
+enum class constraint_kind {
+    /// No more than one of the arguments may be given
+    at_most_one,
+    /// Exactly one of the arguments must be given
+    exactly_one,
+    /// One or more of the arguments must be given
+    at_least_one,
+    /// If the first argument is given, then all of the others must also be given
+    dependency,
+};
+
+/**
+ * @brief The words of a command line that the parser did not consume, to be forwarded to another
+ * program (see params::for_parse::remainder).
+ *
+ * The words are recorded as indices into the words that were parsed, so forwarding them does not
+ * copy any strings. For parse_main_argv(), index `i` refers to `argv[i + 1]`.
+ */
+struct parse_remainder {
+    enum stop_mode : std::uint8_t {
+        /// Each unrecognized word is recorded, and parsing continues with the next word
+        skip_unknown,
+        /// The first unrecognized word and every word after it are recorded
+        stop_at_unknown,
+    };
+    stop_mode mode = skip_unknown;
+
+    /// The indices of the unconsumed words, in order. Cleared at the start of each parse.
+    std::vector<std::size_t> indices{};
+
+    /// View the unconsumed words within the words that were parsed
+    template <std::ranges::random_access_range R>
+    auto words(R& parsed) const {
+        return indices | std::views::transform([&parsed](std::size_t idx) -> decltype(auto) {
+                   return std::ranges::begin(parsed)[static_cast<std::ptrdiff_t>(idx)];
+               });
+    }
+};
+
+/// A problem with a command line that was recorded by a parse with params::for_parse::diagnostics
+struct parse_diagnostic {
+    /// The index of the word that caused the problem, or -1 for a problem that was found after
+    /// the words were parsed (e.g. a missing required argument, or an error in a config file)
+    std::ptrdiff_t word_index = -1;
+    /// The error that would otherwise have been thrown. Rethrow it to inspect its type.
+    std::exception_ptr error{};
+    /// The message of the error
+    std::string message{};
+};
+
+/**
+ * @brief A compact record of what a parse matched (see params::for_parse::summary).
+ *
+ * Nothing is copied: values are views into the parsed words (or the config file), and subcommand
+ * names are views into the parser definition.
+ */
+struct parse_summary {
+    /// A value that was bound to an argument
+    struct binding {
+        /// The depth of the parser that owns the argument. Zero is the top-level parser.
+        std::size_t parser_depth;
+        /// The ordinal of the argument within its parser
+        std::size_t argument_index;
+        /// The index of the word that gave the argument, or -1 for a value from a config file
+        std::ptrdiff_t word_index;
+        /// The value. Empty for an argument that takes no value.
+        std::string_view value;
+    };
+
+    /// Every value that was bound, in order. Default values are not included.
+    std::vector<binding> bindings{};
+    /// The subcommands that were selected, in order
+    std::vector<std::string_view> subcommand_path{};
+};
+
 namespace params {
 
 struct for_argument_parser {
     opt_string prog        = std::nullopt;
     opt_string description = std::nullopt;
     opt_string epilog      = std::nullopt;
+    /**
+     * The resource that the parsers of the tree, their lookup tables, and the names and help
+     * text of their arguments are allocated from. Must outlive the parser and all of its
+     * subparsers. If null, the default resource is used.
+     */
+    std::pmr::memory_resource* memory = nullptr;
 };
 
 struct for_subparser {
@@ -39,7 +142,7 @@ struct for_subparser {
 struct for_subparser_group {
     std::string title = "subcommands";
 
-    std::function<void(std::string_view, std::string_view)> action;
+    argument_action action;
 
     opt_string description{};
 
@@ -48,15 +151,136 @@ struct for_subparser_group {
     opt_string help{};
 };
 
+struct for_constraint {
+    constraint_kind kind;
+    /// Arguments that were returned by add_argument() on the same parser
+    std::vector<argument> arguments;
+};
+
+struct for_parse {
+    /// An observer that will receive events during parsing. May be null.
+    parse_observer* observer = nullptr;
+    /// Settings to apply for arguments that were not given on the command line. May be null.
+    const config_file* config = nullptr;
+    /// Reusable storage for the parse. If null, temporary storage is used.
+    parse_context* context = nullptr;
+    /**
+     * Runs argument validators concurrently. Each validator is passed to the executor as a task
+     * as soon as its value is bound, and all tasks are joined before the parse returns. If not
+     * provided, validators run immediately when their value is bound.
+     */
+    std::function<void(std::function<void()>)> executor{};
+    /**
+     * The object that context-relative actions store into (see parse_target). Lets a single
+     * parser fill a different object on each parse, including parses on different threads.
+     */
+    parse_target target{};
+    /**
+     * Resume from a checkpoint of the previous parse that used the same context (see
+     * parse_context). Has no effect without a context.
+     */
+    bool incremental = false;
+    /**
+     * Collects the words that the parser does not recognize, instead of failing with
+     * unknown_argument: options that are not known (or short clusters whose first letter is not
+     * known), and positional words that no positional argument or subcommand takes. The word
+     * "--" stops the parse, and the words after it are collected too. May be null.
+     */
+    parse_remainder* remainder = nullptr;
+    /**
+     * If false, the parse only checks that the words are well-formed: arguments are matched and
+     * checked against their choices, validators and constraints, and required arguments are
+     * checked, but no action is invoked and no default is applied.
+     */
+    bool run_actions = true;
+    /**
+     * Collects every problem with the command line instead of throwing the first one. After an
+     * error (any debate::runtime_error, such as an unknown argument, a missing or invalid value,
+     * or a repeated argument) the word that caused it is skipped, along with any value words
+     * that its argument took, and parsing continues after them. Missing required arguments and
+     * unmet constraints are each recorded too. The list is cleared at the start of the parse,
+     * and the parse succeeded if it is still empty. Help requests and errors in the parser
+     * definition are still thrown. May be null.
+     */
+    std::vector<parse_diagnostic>* diagnostics = nullptr;
+    /**
+     * Records the matched arguments, their values, and the selected subcommands. Combined with
+     * `run_actions = false`, this checks a command line and describes it without running any
+     * actions. The summary is cleared at the start of the parse. May be null.
+     */
+    parse_summary* summary = nullptr;
+    /**
+     * The resource that the working storage of the parse is allocated from when there is no
+     * context (a context has its own resource), along with the copies of the words if they are
+     * temporaries. If null, the default resource is used.
+     */
+    std::pmr::memory_resource* memory = nullptr;
+};
+
 }  // namespace params
 
 namespace detail {
 
 struct argument_parser_impl;
+struct parse_context_data;
 
 }  // namespace detail
 
+/**
+ * @brief Reusable working storage for argument_parser::parse_args()
+ *
+ * Passing a context in params::for_parse lets the parse keep its working storage in the context.
+ * The storage keeps its capacity between parses, so repeated parses of similar command lines do
+ * not allocate once the context has warmed up. A context may only be used by one parse at a
+ * time.
+ *
+ * With params::for_parse::incremental, the context also records a checkpoint of the parse state
+ * after each step (usually one word, or a word and its values). The next incremental parse with
+ * the same root parser compares its words to those of the previous parse, restores the last
+ * checkpoint that does not depend on any changed word, and parses only the remaining words. This
+ * suits an interactive shell that re-parses a line as it is edited.
+ *
+ * Side effects are not replayed for the words before the checkpoint: their actions and validators
+ * are not invoked again, and the observer receives no events for them. Actions of the earlier
+ * parse are not undone either. An incremental parse is therefore best used with an observer or
+ * with actions whose results are only used once the line is complete (when a full parse can be
+ * done). The words after the checkpoint, config settings, and the final required-argument and
+ * constraint checks are processed as usual.
+ *
+ * The parser must not be modified between incremental parses, unless clear_checkpoints() is
+ * called. An incremental context keeps the parsers that were selected alive between parses.
+ */
+class parse_context {
+    friend argument_parser;
+
+    std::unique_ptr<detail::parse_context_data> _data;
+
+    std::pmr::vector<std::string_view>& _words() noexcept;
+
+public:
+    /// Create a context that allocates its storage from the given resource, which must outlive
+    /// the context
+    explicit parse_context(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    parse_context(parse_context&&) noexcept;
+    parse_context& operator=(parse_context&&) noexcept;
+    ~parse_context();
+
+    /// The index of the word at which the most recent parse started (zero for a full parse)
+    std::size_t resumed_at() const noexcept;
+    /// Forget the checkpoints, so that the next parse starts from the first word
+    void clear_checkpoints() noexcept;
+    /**
+     * @brief The number of lookups made by the most recent parse: each name table, short name,
+     * positional argument and subcommand table that was examined, and each word that was checked
+     * for a help request or gathered into help search terms.
+     *
+     * This measures the work of a parse without timing it. It grows linearly with the input.
+     */
+    std::size_t probes() const noexcept;
+};
+
 class subparser_group;
+class argument_group;
 
 class argument_parser {
     friend subparser_group;
@@ -64,7 +288,11 @@ class argument_parser {
 
     std::shared_ptr<detail::argument_parser_impl> _impl;
 
-    void _parse_args(argv_array argv) const;
+    void _parse_words(std::span<const std::string_view> words, params::for_parse) const;
+
+    static std::pmr::memory_resource* _memory_of(const params::for_parse& p) noexcept {
+        return p.memory ? p.memory : std::pmr::get_default_resource();
+    }
 
     argument_parser(params::for_argument_parser,
                     std::shared_ptr<detail::argument_parser_impl> parent);
@@ -77,11 +305,52 @@ public:
 
     subparser_group add_subparsers(params::for_subparser_group);
 
+    /**
+     * @brief Add a rule about which combinations of this parser's arguments may be given.
+     *
+     * A conflict (for at_most_one and exactly_one) is raised as soon as the second argument is
+     * matched. Missing arguments are raised after all words have been parsed.
+     *
+     * @throws invalid_argument_params if an argument does not belong to this parser
+     */
+    void add_constraint(params::for_constraint);
+
+    /**
+     * @brief Attach an argument group to this parser.
+     *
+     * The group is attached by reference: it is not copied, and arguments that are later added to
+     * the group are also visible to this parser. Its arguments follow this parser's own arguments
+     * in ordinal order.
+     */
+    void add_group(const argument_group& group);
+
     template <std::ranges::input_range R>
     requires std::convertible_to<std::ranges::range_reference_t<R>, std::string_view>
-    void parse_args(R&& r) const { _parse_args(argv_array(r)); }
-
-    void parse_main_argv(int argc, const char* const* argv) const;
+    void parse_args(R&& r, params::for_parse p = {}) const {
+        using word_type = std::ranges::range_reference_t<R>;
+        if constexpr (std::is_lvalue_reference_v<word_type>
+                      or std::is_pointer_v<std::remove_cvref_t<word_type>>
+                      or std::same_as<std::remove_cvref_t<word_type>, std::string_view>) {
+            // The words outlive the parse, so they can be viewed without copying them
+            std::pmr::vector<std::string_view> local{_memory_of(p)};
+            auto& words = p.context ? p.context->_words() : local;
+            words.clear();
+            for (auto&& word : r) {
+                words.emplace_back(std::string_view(word));
+            }
+            _parse_words(words, p);
+        } else {
+            // The words are temporaries, so keep a copy of them
+            std::pmr::vector<std::pmr::string> copy{_memory_of(p)};
+            for (auto&& word : r) {
+                copy.emplace_back(std::string_view(word));
+            }
+            std::pmr::vector<std::string_view> words(copy.begin(), copy.end(), _memory_of(p));
+            _parse_words(words, p);
+        }
+    }
+
+    void parse_main_argv(int argc, const char* const* argv, params::for_parse p = {}) const;
 
     std::string arg_usage_string(category cat) const noexcept;
 
@@ -89,6 +358,47 @@ public:
     std::string usage_string(category cat, std::string_view progname) const noexcept;
     std::string help_string(category cat) const noexcept;
     std::string help_string(category cat, std::string_view progname) const noexcept;
+
+    /**
+     * @brief Estimate the memory used by this parser and everything attached to it.
+     *
+     * The estimate is computed from container sizes and capacities, so it does not include
+     * allocator overhead or memory that actions allocate for themselves. Strings that are shared
+     * by several arguments and groups that are attached to several parsers are counted once.
+     * Subparsers that are loaded lazily are only counted once they have been loaded.
+     *
+     * Must not be called while the parser is being used to parse on another thread.
+     */
+    memory_report memory_usage() const;
+};
+
+/**
+ * @brief A set of named arguments that can be shared by many parsers (e.g. options that are
+ * common to every subcommand).
+ *
+ * The arguments are stored once, and each parser that the group is attached to with
+ * argument_parser::add_group() refers to the same table. During a parse, a group's arguments are
+ * tracked once no matter how many parsers in the chain of subcommands have the group attached:
+ * giving a non-repeatable argument at two levels is an error, and required arguments are checked
+ * once. Copies of an argument_group refer to the same group.
+ */
+class argument_group {
+    friend argument_parser;
+
+    std::shared_ptr<detail::argument_parser_impl> _impl;
+
+public:
+    argument_group();
+    /// Create a group that is allocated, along with its names and help text, from the given
+    /// resource, which must outlive the group and every parser that it is attached to
+    explicit argument_group(std::pmr::memory_resource* memory);
+
+    /**
+     * @brief Add an argument to the group.
+     *
+     * @throws invalid_argument_params if the argument is positional
+     */
+    debate::argument add_argument(params::for_argument p);
 };
 
 /// Error data: The argument_parser thaht saw the error (including a subparser)
@@ -96,6 +406,16 @@ struct e_argument_parser {
     argument_parser value;
 };
 
+/// Error data: The argument constraint that was violated
+struct e_constraint {
+    params::for_constraint value;
+};
+
+/// Error data: The argument that was already given, which conflicts with the current argument
+struct e_conflicting_argument {
+    argument value;
+};
+
 class subparser_group {
     friend argument_parser;
 
@@ -122,4 +442,10 @@ struct e_parsing_word {
     std::string value;
 };
 
+// Error data: Known argument or subcommand names that are close to an unrecognized word, nearest
+// first. Only computed if the error handler asks for it.
+struct e_did_you_mean {
+    std::vector<std::string> value;
+};
+
 }  // namespace debate
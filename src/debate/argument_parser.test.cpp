@@ -6,6 +6,11 @@
 #include <catch2/catch.hpp>
 
 #include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 using debate::argument_parser;
 using debate::opt_string;
@@ -525,3 +530,905 @@ TEST_CASE("Subparsers") {
             });
     }
 }
+
+namespace {
+
+struct recording_observer : debate::parse_observer {
+    std::vector<debate::parse_event> events;
+    std::vector<std::string>         words;
+    bool                             saw_unknown_argument = false;
+
+    void on_event(const debate::parse_event& ev) override {
+        events.push_back(ev);
+        words.emplace_back(ev.word);
+        if (dynamic_cast<const debate::unknown_argument*>(ev.error)) {
+            saw_unknown_argument = true;
+        }
+    }
+
+    /// Encode the events as a compact binary trace: (kind, depth, ordinal) triples
+    std::vector<std::uint8_t> trace() const {
+        std::vector<std::uint8_t> ret;
+        for (auto& ev : events) {
+            ret.push_back(static_cast<std::uint8_t>(ev.kind));
+            ret.push_back(static_cast<std::uint8_t>(ev.parser_depth));
+            ret.push_back(static_cast<std::uint8_t>(ev.argument_index));
+        }
+        return ret;
+    }
+};
+
+}  // namespace
+
+TEST_CASE("Parse observer") {
+    using kind = debate::parse_event_kind;
+    argument_parser p;
+    opt_string      flag_value;
+    p.add_argument({
+        .names       = {"--verbose", "-v"},
+        .action      = debate::null_action,
+        .wants_value = false,
+    });
+    p.add_argument({
+        .names  = {"--flag", "-f"},
+        .action = debate::store_string(flag_value),
+    });
+    auto grp = p.add_subparsers({.action = debate::null_action});
+    auto sub = grp.add_parser({.name = "build"});
+    sub.add_argument({.names = {"target"}, .action = debate::null_action});
+
+    recording_observer obs;
+
+    SECTION("Successful parse") {
+        p.parse_args(std::vector<std::string>{"-v", "--flag=meow", "build", "all"},
+                     {.observer = &obs});
+        CHECK(flag_value == "meow");
+        std::vector<std::uint8_t> expect = {
+            // -v
+            0, 0, 0,  // word_lexed
+            1, 0, 0,  // argument_matched --verbose
+            2, 0, 0,  // value_bound --verbose
+            // --flag=meow
+            0, 0, 0,  // word_lexed
+            1, 0, 1,  // argument_matched --flag
+            2, 0, 1,  // value_bound --flag
+            // build
+            0, 0, 0,  // word_lexed
+            3, 1, 0,  // subparser_entered
+            // all
+            0, 1, 0,  // word_lexed
+            1, 1, 0,  // argument_matched <target>
+            2, 1, 0,  // value_bound <target>
+            // finalize
+            4, 1, 0,  // finalize_check <target>
+        };
+        CHECK(obs.trace() == expect);
+        CHECK(obs.events[5].value == "meow");
+        CHECK(obs.events[4].spelling == "--flag");
+        CHECK(obs.words[3] == "--flag=meow");
+        CHECK(obs.events[7].spelling == "build");
+        CHECK(obs.events[10].value == "all");
+    }
+
+    SECTION("Error event") {
+        CHECK_THROWS_AS(p.parse_args(std::vector<std::string>{"-v", "--bogus"}, {.observer = &obs}),
+                        debate::unknown_argument);
+        REQUIRE_FALSE(obs.events.empty());
+        auto& last = obs.events.back();
+        CHECK(last.kind == kind::error_raised);
+        CHECK(last.word_index == 1);
+        CHECK(obs.words.back() == "--bogus");
+        CHECK(obs.saw_unknown_argument);
+    }
+}
+
+TEST_CASE("Suggestions for unknown names") {
+    argument_parser p;
+    p.add_argument({.names = {"--verbose", "-v"}, .action = debate::null_action});
+    p.add_argument({.names = {"--version"}, .action = debate::null_action});
+    p.add_argument({
+        .names    = {"--verbatim"},
+        .action   = debate::null_action,
+        .category = debate::hidden,
+    });
+    auto grp = p.add_subparsers({.action = debate::null_action});
+    grp.add_parser({.name = "build"});
+    grp.add_parser({.name = "built-in"});
+    grp.add_parser({.name = "test"});
+
+    auto suggestions_for = [&](std::initializer_list<std::string_view> argv) {
+        return boost::leaf::try_catch(
+            [&] {
+                p.parse_args(argv);
+                FAIL_CHECK("Did not throw");
+                return std::vector<std::string>{};
+            },
+            [](debate::unknown_argument, debate::e_did_you_mean dym) { return dym.value; },
+            [](debate::invalid_argument_value, debate::e_did_you_mean dym) { return dym.value; });
+    };
+
+    CHECK(suggestions_for({"--verbos=12", "build"})
+          == std::vector<std::string>{"--verbose", "--version"});
+    CHECK(suggestions_for({"bulid"}) == std::vector<std::string>{"build"});
+    CHECK(suggestions_for({"tset"}) == std::vector<std::string>{"test"});
+    CHECK(suggestions_for({"--nothing-like-it"}).empty());
+}
+
+TEST_CASE("Apply a config file") {
+    argument_parser          p;
+    opt_string               jobs;
+    debate::opt_bool         verbose;
+    std::vector<std::string> defines;
+    opt_string               input;
+    opt_string               release_output;
+
+    p.add_argument({.names = {"--jobs", "-j"}, .action = debate::store_string(jobs)});
+    p.add_argument({
+        .names       = {"--verbose"},
+        .action      = debate::store_true(verbose),
+        .wants_value = false,
+    });
+    p.add_argument({
+        .names      = {"--define", "-D"},
+        .action     = debate::store_string(std::back_inserter(defines)),
+        .can_repeat = true,
+    });
+    auto grp   = p.add_subparsers({.action = debate::null_action, .required = false});
+    auto build = grp.add_parser({.name = "build"});
+    build.add_argument({.names = {"input"}, .action = debate::store_string(input)});
+    auto release = build.add_subparsers({.action = debate::null_action, .required = false})
+                       .add_parser({.name = "release"});
+    release.add_argument({.names = {"--output"}, .action = debate::store_string(release_output)});
+
+    auto cfg = debate::config_file::from_string(R"(
+        jobs = 4
+        verbose = yes
+        define = A
+        define = B
+
+        [build]
+        input = from-config.txt
+
+        [build.release]
+        output = out.bin
+    )");
+
+    auto parse = [&](std::initializer_list<std::string_view> argv) {
+        p.parse_args(argv, {.config = &cfg});
+    };
+
+    SECTION("Config fills in everything") {
+        parse({"build"});
+        CHECK(jobs == "4");
+        CHECK(verbose == true);
+        CHECK(defines == std::vector<std::string>{"A", "B"});
+        CHECK(input == "from-config.txt");
+        CHECK_FALSE(release_output.has_value());
+    }
+
+    SECTION("Nested sections") {
+        parse({"build", "given.txt", "release"});
+        CHECK(input == "given.txt");
+        CHECK(release_output == "out.bin");
+    }
+
+    SECTION("Command line takes precedence") {
+        parse({"-j8", "-DC", "build", "given.txt"});
+        CHECK(jobs == "8");
+        CHECK(defines == std::vector<std::string>{"C"});
+        CHECK(input == "given.txt");
+        // Not selected:
+        CHECK_FALSE(release_output.has_value());
+    }
+
+    SECTION("Unselected sections are ignored") {
+        parse({});
+        CHECK(jobs == "4");
+        CHECK_FALSE(input.has_value());
+    }
+
+    SECTION("Repetition rules apply") {
+        cfg = debate::config_file::from_string("jobs = 1\njobs = 2");
+        boost::leaf::try_catch(
+            [&] {
+                parse({});
+                FAIL_CHECK("Did not throw");
+            },
+            [&](debate::invalid_argument_repetition, debate::e_config_line line) {
+                CHECK(line.value == 2);
+            });
+    }
+
+    SECTION("Unknown keys are errors") {
+        cfg = debate::config_file::from_string("\n[build]\njbos = 1");
+        boost::leaf::try_catch(
+            [&] {
+                parse({"build", "x"});
+                FAIL_CHECK("Did not throw");
+            },
+            [&](debate::unknown_argument, debate::e_config_line line, debate::e_argument_parser) {
+                CHECK(line.value == 3);
+            });
+    }
+
+    SECTION("Unknown sections are errors") {
+        cfg = debate::config_file::from_string("[nope]\njobs = 1");
+        CHECK_THROWS_AS(parse({}), debate::invalid_config_syntax);
+    }
+}
+
+TEST_CASE("Validators run on an executor") {
+    argument_parser p;
+
+    // Each validator waits until both have started, which only succeeds if they run concurrently
+    std::mutex              mtx;
+    std::condition_variable cv;
+    int                     n_started  = 0;
+    bool                    concurrent = true;
+    auto                    rendezvous = [&](std::string_view, std::string_view value) {
+        std::unique_lock lk{mtx};
+        ++n_started;
+        cv.notify_all();
+        if (not cv.wait_for(lk, std::chrono::seconds{5}, [&] { return n_started == 2; })) {
+            concurrent = false;
+        }
+        if (value == "bad") {
+            throw std::runtime_error("Invalid value");
+        }
+    };
+    p.add_argument({
+        .names    = {"--first"},
+        .action   = debate::null_action,
+        .validate = rendezvous,
+    });
+    p.add_argument({
+        .names    = {"--second"},
+        .action   = debate::null_action,
+        .validate = rendezvous,
+    });
+
+    std::vector<std::jthread> threads;
+    auto executor = [&](std::function<void()> task) { threads.emplace_back(std::move(task)); };
+
+    SECTION("All validators pass") {
+        p.parse_args(std::vector<std::string>{"--first=a", "--second=b"}, {.executor = executor});
+        CHECK(n_started == 2);
+        CHECK(concurrent);
+    }
+
+    SECTION("A failure is raised with the argument context") {
+        boost::leaf::try_catch(
+            [&] {
+                p.parse_args(std::vector<std::string>{"--first=a", "--second=bad"},
+                             {.executor = executor});
+                FAIL_CHECK("Did not throw");
+            },
+            [&](const std::runtime_error&,
+                debate::e_argument_name  name,
+                debate::e_argument_value val) {
+                CHECK(name.value == "--second");
+                CHECK(val.value == "bad");
+            });
+        CHECK(concurrent);
+    }
+}
+
+TEST_CASE("Validators run inline without an executor") {
+    argument_parser p;
+    std::vector<std::string> order;
+    p.add_argument({
+        .names    = {"--size"},
+        .action   = [&](auto, auto) { order.push_back("action"); },
+        .validate =
+            [&](auto, auto value) {
+                order.push_back("validate");
+                if (value == "0") {
+                    throw std::runtime_error("Size must be non-zero");
+                }
+            },
+    });
+    p.parse_args(std::vector<std::string>{"--size=4"});
+    CHECK(order == std::vector<std::string>{"action", "validate"});
+    CHECK_THROWS_AS(p.parse_args(std::vector<std::string>{"--size=0"}), std::runtime_error);
+}
+
+TEST_CASE("Arguments with choices") {
+    enum class level { debug, info, warn };
+    const debate::choice_map<level> levels = {
+        {"debug", level::debug},
+        {"info", level::info},
+        {"warn", level::warn},
+    };
+
+    argument_parser p;
+    level           got = level::info;
+    p.add_argument({
+        .names   = {"--level"},
+        .action  = levels.store(got),
+        .choices = levels.choices(),
+        .help    = "The log level",
+    });
+    auto parse = [&](std::vector<std::string> argv) { p.parse_args(argv); };
+
+    parse({"--level=warn"});
+    CHECK(got == level::warn);
+
+    boost::leaf::try_catch(
+        [&] {
+            parse({"--level", "verbose"});
+            FAIL_CHECK("Did not throw");
+        },
+        [&](const debate::invalid_argument_value& err,
+            debate::e_valid_choices               choices,
+            debate::e_argument_name               name) {
+            CHECK(err.what() == std::string_view("verbose"));
+            CHECK(choices.value == std::vector<std::string>{"debug", "info", "warn"});
+            CHECK(name.value == "--level");
+        });
+    CHECK(got == level::warn);
+
+    CHECK(p.help_string(debate::general).find("Choices: debug, info, warn")
+          != std::string::npos);
+}
+
+TEST_CASE("Argument constraints") {
+    argument_parser p;
+    auto add_flag = [&](std::string name) {
+        return p.add_argument({
+            .names       = {name},
+            .action      = debate::null_action,
+            .can_repeat  = true,
+            .wants_value = false,
+        });
+    };
+    auto json    = add_flag("--json");
+    auto yaml    = add_flag("--yaml");
+    auto text    = add_flag("--text");
+    auto verbose = add_flag("--verbose");
+    auto quiet   = add_flag("--quiet");
+    auto log     = add_flag("--log");
+    auto logfile = add_flag("--log-file");
+    p.add_constraint(
+        {.kind = debate::constraint_kind::exactly_one, .arguments = {json, yaml, text}});
+    p.add_constraint({.kind = debate::constraint_kind::at_most_one, .arguments = {verbose, quiet}});
+    p.add_constraint({.kind = debate::constraint_kind::dependency, .arguments = {logfile, log}});
+
+    auto parse = [&](std::vector<std::string> argv) { p.parse_args(argv); };
+
+    parse({"--json"});
+    parse({"--yaml", "--yaml", "--verbose", "--log", "--log-file"});
+    parse({"--text", "--log"});
+
+    // Conflicts are raised when the second argument is matched
+    boost::leaf::try_catch(
+        [&] {
+            parse({"--json", "--quiet", "--text", "--verbose"});
+            FAIL_CHECK("Did not throw");
+        },
+        [&](debate::conflicting_arguments,
+            debate::e_parsing_word         word,
+            debate::e_conflicting_argument other,
+            debate::e_constraint           con) {
+            CHECK(word.value == "--text");
+            CHECK(other.value.id() == json.id());
+            CHECK(con.value.kind == debate::constraint_kind::exactly_one);
+        });
+
+    boost::leaf::try_catch(
+        [&] {
+            parse({"--verbose"});
+            FAIL_CHECK("Did not throw");
+        },
+        [&](const debate::missing_argument& err, debate::e_constraint con) {
+            CHECK(err.what() == std::string_view("--json / --yaml / --text"));
+            CHECK(con.value.kind == debate::constraint_kind::exactly_one);
+        });
+
+    boost::leaf::try_catch(
+        [&] {
+            parse({"--json", "--log-file"});
+            FAIL_CHECK("Did not throw");
+        },
+        [&](debate::missing_argument, debate::e_argument arg, debate::e_constraint con) {
+            CHECK(arg.value.id() == log.id());
+            CHECK(con.value.kind == debate::constraint_kind::dependency);
+        });
+
+    argument_parser other;
+    auto            foreign = other.add_argument({.names = {"--x"}, .action = debate::null_action});
+    CHECK_THROWS_AS(p.add_constraint({.kind      = debate::constraint_kind::at_most_one,
+                                      .arguments = {json, foreign}}),
+                    debate::invalid_argument_params);
+}
+
+TEST_CASE("Many argument constraints") {
+    // Use enough constraints to span several bitmask words
+    argument_parser               p;
+    std::vector<debate::argument> args;
+    for (int i = 0; i < 300; ++i) {
+        args.push_back(p.add_argument({
+            .names       = {"--opt-" + std::to_string(i)},
+            .action      = debate::null_action,
+            .wants_value = false,
+        }));
+    }
+    for (std::size_t i = 0; i + 1 < args.size(); i += 2) {
+        p.add_constraint(
+            {.kind = debate::constraint_kind::at_most_one, .arguments = {args[i], args[i + 1]}});
+    }
+    p.parse_args(std::vector<std::string>{"--opt-0", "--opt-3", "--opt-297", "--opt-298"});
+    CHECK_THROWS_AS(p.parse_args(std::vector<std::string>{"--opt-0", "--opt-296", "--opt-297"}),
+                    debate::conflicting_arguments);
+}
+
+TEST_CASE("Shared argument groups") {
+    debate::argument_group common;
+    int                    verbosity = 0;
+    opt_string             output;
+    common.add_argument({
+        .names       = {"--verbose", "-v"},
+        .action      = [&](auto, auto) { ++verbosity; },
+        .can_repeat  = true,
+        .wants_value = false,
+    });
+    common.add_argument({
+        .names  = {"--output", "-o"},
+        .action = debate::store_string(output),
+        .help   = "Where to write output",
+    });
+    CHECK_THROWS_AS(common.add_argument({.names = {"file"}, .action = debate::null_action}),
+                    debate::invalid_argument_params);
+
+    argument_parser p;
+    p.add_group(common);
+    auto grp = p.add_subparsers({.action = debate::null_action});
+    for (auto name : {"build", "test", "install"}) {
+        grp.add_parser({.name = name}).add_group(common);
+    }
+    CHECK_THROWS_AS(p.add_group(common), debate::invalid_argument_params);
+
+    auto parse = [&](std::vector<std::string> argv) {
+        verbosity = 0;
+        output.reset();
+        p.parse_args(argv);
+    };
+
+    parse({"-v", "build", "-vv", "--output=out.txt"});
+    CHECK(verbosity == 3);
+    CHECK(output == "out.txt");
+
+    // Arguments in a group are tracked once across the whole chain
+    CHECK_THROWS_AS(parse({"-o", "a", "test", "-o", "b"}), debate::invalid_argument_repetition);
+
+    CHECK(p.help_string(debate::general).find("Where to write output") != std::string::npos);
+
+    // Arguments that are added to the group later are visible to every parser
+    common.add_argument({.names = {"--jobs"}, .action = debate::null_action, .required = true});
+    parse({"install", "--jobs", "4"});
+    CHECK_THROWS_AS(parse({"install"}), debate::missing_argument);
+}
+
+TEST_CASE("Argument strings are shared within a parser tree") {
+    auto make_tree = [](int n_subcommands) {
+        argument_parser p;
+        auto            grp = p.add_subparsers({.action = debate::null_action});
+        for (int i = 0; i < n_subcommands; ++i) {
+            auto sub = grp.add_parser({.name = "cmd-" + std::to_string(i)});
+            sub.add_argument({
+                .names  = {"--output-directory", "-o"},
+                .action = debate::null_action,
+                .help   = "The directory in which all of the generated files will be written",
+            });
+        }
+        return p;
+    };
+
+    auto small = make_tree(2);
+    auto large = make_tree(20);
+
+    auto small_mem = small.memory_usage();
+    auto large_mem = large.memory_usage();
+    // The help text is stored once, no matter how many subcommands use it
+    CHECK(small_mem.help_text == large_mem.help_text);
+    CHECK(small_mem.arguments < large_mem.arguments);
+    CHECK(large_mem.total()
+          == large_mem.names + large_mem.help_text + large_mem.arguments + large_mem.actions
+              + large_mem.indexes + large_mem.subparsers);
+}
+
+TEST_CASE("Context-relative actions") {
+    struct options {
+        std::string name;
+        std::string command;
+        bool        verbose = false;
+        int         level   = 0;
+    };
+    argument_parser p;
+    p.add_argument({.names = {"--name"}, .action = debate::store_string(&options::name)});
+    p.add_argument({
+        .names       = {"--verbose", "-v"},
+        .action      = debate::store_true(&options::verbose),
+        .wants_value = false,
+    });
+    p.add_argument({
+        .names       = {"--max"},
+        .action      = debate::store_value(&options::level, 9),
+        .wants_value = false,
+    });
+    auto grp = p.add_subparsers({.action = debate::store_string(&options::command)});
+    grp.add_parser({.name = "build"});
+    grp.add_parser({.name = "test"});
+
+    // One parser fills a different object on each thread
+    std::vector<options>     results(8);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&, i] {
+            for (int n = 0; n < 50; ++n) {
+                std::vector<std::string> argv = {"--name=n" + std::to_string(i),
+                                                 i % 2 ? "build" : "test"};
+                if (i % 3 == 0) {
+                    argv.insert(argv.begin(), "-v");
+                }
+                p.parse_args(argv, {.target = results[i]});
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        CHECK(results[i].name == "n" + std::to_string(i));
+        CHECK(results[i].command == (i % 2 ? "build" : "test"));
+        CHECK(results[i].verbose == (i % 3 == 0));
+    }
+
+    options opts;
+    p.parse_args(std::vector<std::string>{"--max", "build"}, {.target = opts});
+    CHECK(opts.level == 9);
+
+    // A context-relative action needs a target of the right type
+    CHECK_THROWS_AS(p.parse_args(std::vector<std::string>{"--name=x", "build"}),
+                    debate::invalid_argument_params);
+    int wrong = 0;
+    CHECK_THROWS_AS(p.parse_args(std::vector<std::string>{"--name=x", "build"}, {.target = wrong}),
+                    debate::invalid_argument_params);
+}
+
+TEST_CASE("Arguments with several values") {
+    argument_parser               p;
+    std::vector<std::string>      inputs;
+    std::vector<std::string>      files;
+    std::vector<std::string>      tags;
+    opt_string                    level;
+    std::size_t                   n_input_calls = 0;
+    std::vector<std::vector<int>> pairs;
+    p.add_argument({
+        .names  = {"--inputs", "-i"},
+        .action =
+            [&](std::string_view, debate::value_span values) {
+                ++n_input_calls;
+                inputs.insert(inputs.end(), values.begin(), values.end());
+            },
+        .can_repeat = true,
+        .nargs      = '+',
+    });
+    p.add_argument({
+        .names  = {"--pair"},
+        .action =
+            [&](std::string_view, debate::value_span values) {
+                auto& pair = pairs.emplace_back();
+                for (auto v : values) {
+                    pair.push_back(std::stoi(std::string(v)));
+                }
+            },
+        .can_repeat = true,
+        .nargs      = 2,
+    });
+    p.add_argument({
+        .names     = {"--tags"},
+        .action    = [&](auto, auto tag) { tags.emplace_back(tag); },
+        .delimiter = ',',
+    });
+    p.add_argument({
+        .names   = {"--level"},
+        .action  = debate::store_string(level),
+        .choices = debate::choice_set{"low", "high"},
+        .nargs   = '?',
+    });
+    p.add_argument({
+        .names  = {"files"},
+        .action = [&](auto, auto file) { files.emplace_back(file); },
+        .nargs  = '*',
+    });
+    auto parse = [&](std::vector<std::string> argv) {
+        inputs.clear();
+        files.clear();
+        tags.clear();
+        pairs.clear();
+        level.reset();
+        n_input_calls = 0;
+        p.parse_args(argv);
+    };
+
+    parse({"--inputs", "a", "b", "c", "--tags=x,y,,z", "-i", "d"});
+    CHECK(inputs == std::vector<std::string>{"a", "b", "c", "d"});
+    CHECK(n_input_calls == 2);
+    CHECK(tags == std::vector<std::string>{"x", "y", "", "z"});
+
+    // Values end at the next option
+    parse({"--pair", "1", "2", "--pair", "3", "4", "f1", "f2"});
+    CHECK(pairs == std::vector<std::vector<int>>{{1, 2}, {3, 4}});
+    CHECK(files == std::vector<std::string>{"f1", "f2"});
+
+    parse({"--inputs=a", "--level"});
+    CHECK(inputs == std::vector<std::string>{"a"});
+    CHECK_FALSE(level.has_value());
+    parse({"--level", "high"});
+    CHECK(level == "high");
+
+    // Negative numbers are values, not options
+    parse({"--inputs", "-1", "-2.5", "-.5", "--level"});
+    CHECK(inputs == std::vector<std::string>{"-1", "-2.5", "-.5"});
+    parse({"--inputs=-1", "--pair", "-2", "-3"});
+    CHECK(inputs == std::vector<std::string>{"-1"});
+    CHECK(pairs == std::vector<std::vector<int>>{{-2, -3}});
+
+    // Positionals that accept zero values are not required
+    parse({});
+    CHECK(files.empty());
+
+    CHECK_THROWS_AS(parse({"--inputs"}), debate::missing_argument_value);
+    CHECK_THROWS_AS(parse({"--inputs", "--level"}), debate::missing_argument_value);
+    CHECK_THROWS_AS(parse({"--pair", "1"}), debate::missing_argument_value);
+    CHECK_THROWS_AS(parse({"--pair=1"}), debate::missing_argument_value);
+    CHECK_THROWS_AS(parse({"--level", "medium"}), debate::invalid_argument_value);
+
+    // One action call for many values
+    std::vector<std::string> many = {"--inputs"};
+    for (int i = 0; i < 5000; ++i) {
+        many.push_back("input-" + std::to_string(i));
+    }
+    parse(many);
+    CHECK(inputs.size() == 5000);
+    CHECK(n_input_calls == 1);
+
+    CHECK(p.usage_string(debate::general, "prog").find("--inputs <inputs> [<inputs> ...]")
+          != std::string::npos);
+    CHECK_THROWS_AS(debate::value_count('x'), debate::invalid_argument_params);
+    CHECK_THROWS_AS(p.add_argument({
+                        .names       = {"--bad"},
+                        .action      = debate::null_action,
+                        .wants_value = false,
+                        .nargs       = 2,
+                    }),
+                    debate::invalid_argument_params);
+}
+
+TEST_CASE("Negative numbers end values if the parser has options that look like numbers") {
+    argument_parser          p;
+    std::vector<std::string> nums;
+    bool                     one = false;
+    p.add_argument({
+        .names  = {"--nums"},
+        .action = [&](auto, auto num) { nums.emplace_back(num); },
+        .nargs  = '+',
+    });
+    p.add_argument({
+        .names       = {"-1"},
+        .action      = debate::store_true(one),
+        .wants_value = false,
+    });
+    p.parse_args(std::vector<std::string>{"--nums", "5", "-1"});
+    CHECK(nums == std::vector<std::string>{"5"});
+    CHECK(one);
+    CHECK_THROWS_AS(p.parse_args(std::vector<std::string>{"--nums", "-2"}),
+                    debate::missing_argument_value);
+}
+
+TEST_CASE("Leave unknown words in a remainder") {
+    argument_parser p;
+    bool            verbose = false;
+    std::string     output;
+    p.add_argument({
+        .names       = {"--verbose", "-v"},
+        .action      = debate::store_true(verbose),
+        .wants_value = false,
+    });
+    p.add_argument({
+        .names    = {"--output", "-o"},
+        .action   = debate::store_string(output),
+        .required = false,
+    });
+
+    debate::parse_remainder  rem;
+    std::vector<std::string> argv
+        = {"--color", "-v", "-x1", "file.c", "-o", "a.out", "--", "-v", "--output"};
+    p.parse_args(argv, {.remainder = &rem});
+    CHECK(verbose);
+    CHECK(output == "a.out");
+    CHECK(rem.indices == std::vector<std::size_t>{0, 2, 3, 7, 8});
+    auto words = rem.words(argv);
+    CHECK(std::vector<std::string>(words.begin(), words.end())
+          == std::vector<std::string>{"--color", "-x1", "file.c", "-v", "--output"});
+
+    // Stop at the first word that is not known
+    rem = {.mode = debate::parse_remainder::stop_at_unknown};
+    output.clear();
+    p.parse_args(std::vector<std::string>{"-v", "cc", "-o", "x", "y"}, {.remainder = &rem});
+    CHECK(rem.indices == std::vector<std::size_t>{1, 2, 3, 4});
+    CHECK(output.empty());
+
+    // A short cluster that starts with a known letter is still an error
+    CHECK_THROWS_AS(p.parse_args(std::vector<std::string>{"-vq"}, {.remainder = &rem}),
+                    debate::unknown_argument);
+    // As is an unknown word without a remainder
+    CHECK_THROWS_AS(p.parse_args(std::vector<std::string>{"--"}), debate::unknown_argument);
+
+    // A word that is not a subcommand is left too
+    auto grp = p.add_subparsers({.action = debate::null_action, .required = false});
+    grp.add_parser({.name = "build"});
+    rem  = {};
+    argv = {"child-tool", "x"};
+    p.parse_args(argv, {.remainder = &rem});
+    CHECK(rem.indices == std::vector<std::size_t>{0, 1});
+    CHECK_THROWS_AS(p.parse_args(argv), debate::invalid_argument_value);
+}
+
+TEST_CASE("Default values") {
+    argument_parser p;
+    std::string     jobs;
+    std::string     cache;
+    std::string     input;
+    int             n_probes = 0;
+    p.add_argument({
+        .names         = {"--jobs", "-j"},
+        .action        = debate::store_string(jobs),
+        .default_value = [&] {
+            ++n_probes;
+            return std::string("8");
+        },
+    });
+    p.add_argument({
+        .names         = {"--cache"},
+        .action        = debate::store_string(cache),
+        .default_value = "/var/cache",
+        .help          = "Where to keep things",
+    });
+    p.add_argument({
+        .names         = {"input"},
+        .action        = debate::store_string(input),
+        .default_value = "-",
+    });
+
+    p.parse_args(std::vector<std::string>{});
+    CHECK(jobs == "8");
+    CHECK(cache == "/var/cache");
+    CHECK(input == "-");
+    CHECK(n_probes == 1);
+
+    // A default is not computed when the argument is given
+    p.parse_args(std::vector<std::string>{"-j4", "file"});
+    CHECK(jobs == "4");
+    CHECK(input == "file");
+    CHECK(n_probes == 1);
+
+    CHECK(p.help_string(debate::general).find("Default: /var/cache") != std::string::npos);
+
+    CHECK_THROWS_AS(p.add_argument({
+                        .names         = {"--flag"},
+                        .action        = debate::null_action,
+                        .wants_value   = false,
+                        .default_value = "1",
+                    }),
+                    debate::invalid_argument_params);
+    CHECK_THROWS_AS(p.add_argument({
+                        .names         = {"--must"},
+                        .action        = debate::null_action,
+                        .required      = true,
+                        .default_value = "1",
+                    }),
+                    debate::invalid_argument_params);
+}
+
+TEST_CASE("Collect every error in one pass") {
+    argument_parser p;
+    p.add_argument({.names = {"--name"}, .action = debate::null_action, .required = true});
+    p.add_argument({.names = {"--once"}, .action = debate::null_action});
+    p.add_argument({
+        .names   = {"--mode"},
+        .action  = debate::null_action,
+        .choices = debate::choice_set{"fast", "slow"},
+    });
+    p.add_argument({.names = {"input"}, .action = debate::null_action});
+
+    std::vector<debate::parse_diagnostic> diags;
+    p.parse_args(std::vector<std::string>{"--bogus",
+                                          "--once=1",
+                                          "--mode=quick",
+                                          "--once=2",
+                                          "in",
+                                          "extra",
+                                          "--once"},
+                 {.diagnostics = &diags});
+    REQUIRE(diags.size() == 6);
+    auto index_and_type = [&](std::size_t n) {
+        try {
+            std::rethrow_exception(diags[n].error);
+        } catch (const debate::unknown_argument&) {
+            return std::pair{diags[n].word_index, std::string("unknown")};
+        } catch (const debate::invalid_argument_value&) {
+            return std::pair{diags[n].word_index, std::string("invalid")};
+        } catch (const debate::invalid_argument_repetition&) {
+            return std::pair{diags[n].word_index, std::string("repeated")};
+        } catch (const debate::missing_argument_value&) {
+            return std::pair{diags[n].word_index, std::string("no value")};
+        } catch (const debate::missing_argument&) {
+            return std::pair{diags[n].word_index, std::string("missing")};
+        }
+    };
+    CHECK(index_and_type(0) == std::pair{std::ptrdiff_t{0}, std::string("unknown")});
+    CHECK(index_and_type(1) == std::pair{std::ptrdiff_t{2}, std::string("invalid")});
+    CHECK(index_and_type(2) == std::pair{std::ptrdiff_t{3}, std::string("repeated")});
+    CHECK(index_and_type(3) == std::pair{std::ptrdiff_t{5}, std::string("unknown")});
+    CHECK(index_and_type(4) == std::pair{std::ptrdiff_t{6}, std::string("repeated")});
+    CHECK(index_and_type(5) == std::pair{std::ptrdiff_t{-1}, std::string("missing")});
+    CHECK(diags[5].message == "--name");
+
+    // A good command line leaves no diagnostics
+    p.parse_args(std::vector<std::string>{"--name=x", "in"}, {.diagnostics = &diags});
+    CHECK(diags.empty());
+
+    // The value of an option that fails is skipped with it, and is not taken by the positional
+    p.parse_args(std::vector<std::string>{"--name=x", "--mode", "quick", "in"},
+                 {.diagnostics = &diags});
+    REQUIRE(diags.size() == 1);
+    CHECK(index_and_type(0) == std::pair{std::ptrdiff_t{1}, std::string("invalid")});
+
+    argument_parser levels;
+    levels.add_argument({
+        .names   = {"--level"},
+        .action  = debate::null_action,
+        .choices = debate::choice_set{"low", "high"},
+    });
+    levels.parse_args(std::vector<std::string>{"--level", "bogus"}, {.diagnostics = &diags});
+    REQUIRE(diags.size() == 1);
+    CHECK(index_and_type(0) == std::pair{std::ptrdiff_t{0}, std::string("invalid")});
+}
+
+TEST_CASE("Summarize a parse without running actions") {
+    argument_parser p;
+    int             n_actions = 0;
+    auto            count     = [&](auto, auto) { ++n_actions; };
+    p.add_argument({.names = {"--verbose", "-v"}, .action = count, .wants_value = false});
+    auto grp = p.add_subparsers({.action = count});
+    auto run = grp.add_parser({.name = "run"});
+    run.add_argument({.names = {"--env"}, .action = count, .delimiter = ','});
+    run.add_argument({.names = {"target"}, .action = count, .default_value = "all"});
+
+    debate::parse_summary          summary;
+    const std::vector<std::string> argv = {"-v", "run", "--env=a,b", "x"};
+    p.parse_args(argv, {.run_actions = false, .summary = &summary});
+    CHECK(n_actions == 0);
+    CHECK(summary.subcommand_path == std::vector<std::string_view>{"run"});
+    REQUIRE(summary.bindings.size() == 4);
+    CHECK(summary.bindings[0].parser_depth == 0);
+    CHECK(summary.bindings[0].argument_index == 0);
+    CHECK(summary.bindings[0].value.empty());
+    CHECK(summary.bindings[1].parser_depth == 1);
+    CHECK(summary.bindings[1].word_index == 2);
+    CHECK(summary.bindings[1].value == "a");
+    CHECK(summary.bindings[2].value == "b");
+    CHECK(summary.bindings[3].argument_index == 1);
+    CHECK(summary.bindings[3].value == "x");
+    // The values are views of the words
+    CHECK(summary.bindings[3].value.data() == argv[3].data());
+
+    // Defaults are not applied, and a bad command line is still rejected
+    p.parse_args(std::vector<std::string>{"run"}, {.run_actions = false, .summary = &summary});
+    CHECK(summary.bindings.empty());
+    CHECK(n_actions == 0);
+    CHECK_THROWS_AS(p.parse_args(std::vector<std::string>{"run", "--bad"},
+                                 {.run_actions = false, .summary = &summary}),
+                    debate::unknown_argument);
+}
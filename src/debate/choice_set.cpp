@@ -0,0 +1,200 @@
+#include "./choice_set.hpp"
+
+#include "./detail/memory_usage.hpp"
+#include "./error.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+
+using namespace debate;
+using strv = std::string_view;
+using u32  = std::uint32_t;
+using u64  = std::uint64_t;
+
+/**
+ * The table uses "hash and displace": Every word is first hashed into a bucket, and each bucket
+ * has a displacement that is mixed into a second hash to pick the word's slot. Displacements are
+ * chosen when the table is built (largest buckets first) so that no two words share a slot. A
+ * lookup therefore needs one hash of the word and a single comparison.
+ *
+ * No displacement can separate words whose hashes are identical, so the table only grows a few
+ * times before giving up. The set then falls back to a binary search over the sorted words.
+ */
+
+namespace {
+
+constexpr u32 empty_slot = ~u32{0};
+
+u64 hash_word(strv word) noexcept {
+    // FNV-1a
+    u64 h = 0xcbf2'9ce4'8422'2325;
+    for (char c : word) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x0000'0100'0000'01b3;
+    }
+    return h;
+}
+
+/// Derive a well-mixed hash from the word hash and a seed (the SplitMix64 finalizer)
+u64 mix(u64 h, u64 seed) noexcept {
+    h ^= seed * 0x9e37'79b9'7f4a'7c15;
+    h = (h ^ (h >> 30)) * 0xbf58'476d'1ce4'e5b9;
+    h = (h ^ (h >> 27)) * 0x94d0'49bb'1331'11eb;
+    return h ^ (h >> 31);
+}
+
+}  // namespace
+
+struct debate::detail::choice_set_data {
+    std::vector<std::string> words;
+    /// One displacement per bucket
+    std::vector<u32> displacements;
+    /// Indices into `words`, or empty_slot. The size is a power of two, or zero if the table
+    /// could not be built.
+    std::vector<u32> slots;
+    /// Indices into `words`, in order of the words. Only used if there is no table.
+    std::vector<u32> sorted;
+
+    std::size_t bucket_of(u64 h) const noexcept { return mix(h, 0) % displacements.size(); }
+    std::size_t slot_of(u64 h, u32 disp) const noexcept {
+        return mix(h, u64{disp} + 1) & (slots.size() - 1);
+    }
+
+    bool try_build(std::size_t n_slots) {
+        auto n_buckets = std::max<std::size_t>(1, words.size() / 4);
+        displacements.assign(n_buckets, 0);
+        slots.assign(n_slots, empty_slot);
+
+        std::vector<u64> hashes;
+        for (auto& w : words) {
+            hashes.push_back(hash_word(w));
+        }
+        std::vector<std::vector<u32>> buckets(n_buckets);
+        for (u32 idx = 0; idx < words.size(); ++idx) {
+            buckets[bucket_of(hashes[idx])].push_back(idx);
+        }
+        std::vector<std::size_t> order(n_buckets);
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        std::ranges::stable_sort(order, std::greater<>{}, [&](auto b) {
+            return buckets[b].size();
+        });
+
+        std::vector<std::size_t> taken;
+        for (auto b : order) {
+            auto& members = buckets[b];
+            if (members.empty()) {
+                break;
+            }
+            bool placed = false;
+            for (u32 disp = 0; disp < 4096 and not placed; ++disp) {
+                taken.clear();
+                placed = true;
+                for (auto idx : members) {
+                    auto slot = slot_of(hashes[idx], disp);
+                    if (slots[slot] != empty_slot or std::ranges::count(taken, slot) != 0) {
+                        placed = false;
+                        break;
+                    }
+                    taken.push_back(slot);
+                }
+                if (placed) {
+                    displacements[b] = disp;
+                    for (std::size_t i = 0; i < members.size(); ++i) {
+                        slots[taken[i]] = members[i];
+                    }
+                }
+            }
+            if (not placed) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void build() {
+        if (words.empty()) {
+            throw invalid_argument_params{"A choice_set must have at least one word"};
+        }
+        if (words.size() >= empty_slot / 4) {
+            throw invalid_argument_params{"Too many words for a choice_set"};
+        }
+        sorted.resize(words.size());
+        std::iota(sorted.begin(), sorted.end(), u32{0});
+        std::ranges::sort(sorted, std::less<>{}, [&](u32 idx) -> strv { return words[idx]; });
+        auto same_word = [&](u32 a, u32 b) { return words[a] == words[b]; };
+        if (std::ranges::adjacent_find(sorted, same_word) != sorted.end()) {
+            throw invalid_argument_params{"A choice_set must not contain duplicate words"};
+        }
+        // Start at a load factor of at most 0.8, and grow if the displacement search gives up
+        std::size_t n_slots = std::bit_ceil(words.size() + words.size() / 4 + 1);
+        for (int attempt = 0; attempt < 4; ++attempt, n_slots *= 2) {
+            if (try_build(n_slots)) {
+                sorted = {};
+                return;
+            }
+        }
+        displacements = {};
+        slots         = {};
+    }
+
+    std::optional<std::size_t> find_sorted(strv word) const noexcept {
+        auto it = std::ranges::lower_bound(sorted, word, std::less<>{}, [&](u32 idx) -> strv {
+            return words[idx];
+        });
+        if (it != sorted.end() and words[*it] == word) {
+            return *it;
+        }
+        return std::nullopt;
+    }
+};
+
+const detail::choice_set_data& choice_set::_data() const noexcept { return *this; }
+
+choice_set::choice_set(std::vector<std::string> words) {
+    detail::choice_set_data& data = *this;
+    data.words                    = std::move(words);
+    data.build();
+}
+
+choice_set::choice_set(std::initializer_list<std::string_view> words)
+    : choice_set(std::vector<std::string>(words.begin(), words.end())) {}
+
+std::optional<std::size_t> choice_set::find(std::string_view word) const noexcept {
+    auto& data = _data();
+    if (data.slots.empty()) {
+        return data.find_sorted(word);
+    }
+    auto h   = hash_word(word);
+    auto idx = data.slots[data.slot_of(h, data.displacements[data.bucket_of(h)])];
+    if (idx != empty_slot and data.words[idx] == word) {
+        return idx;
+    }
+    return std::nullopt;
+}
+
+const std::vector<std::string>& choice_set::words() const noexcept { return _data().words; }
+
+std::string choice_set::joined(std::string_view sep) const noexcept {
+    std::string ret;
+    for (auto& w : words()) {
+        if (&w != &words().front()) {
+            ret.append(sep);
+        }
+        ret.append(w);
+    }
+    return ret;
+}
+
+std::size_t choice_set::memory_usage() const noexcept {
+    auto&       data = _data();
+    std::size_t ret  = sizeof(data) + data.words.capacity() * sizeof(std::string)
+        + (data.displacements.capacity() + data.slots.capacity() + data.sorted.capacity())
+            * sizeof(u32);
+    for (auto& w : data.words) {
+        ret += detail::heap_bytes(w);
+    }
+    return ret;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <neo/shared.hpp>
+
+#include <cstddef>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace debate {
+
+namespace detail {
+
+struct choice_set_data;
+
+}  // namespace detail
+
+/**
+ * @brief A fixed set of words that an argument accepts as its value.
+ *
+ * A perfect hash table is built over the words when the set is constructed, so looking up a word
+ * takes constant time (plus the cost of hashing the word once) and never allocates. In the
+ * unlikely case that two of the words have the same hash, the set uses a binary search instead.
+ *
+ * Copies of a choice_set share the same underlying table.
+ */
+class choice_set : neo::shared_state<choice_set, detail::choice_set_data> {
+    const detail::choice_set_data& _data() const noexcept;
+
+public:
+    /**
+     * @brief Build a table over the given words.
+     *
+     * @throws invalid_argument_params if the list is empty or contains a duplicate
+     */
+    explicit choice_set(std::vector<std::string> words);
+    choice_set(std::initializer_list<std::string_view> words);
+
+    /// Get the index of the given word in the list the set was created with, or nullopt
+    std::optional<std::size_t> find(std::string_view word) const noexcept;
+    bool contains(std::string_view word) const noexcept { return find(word).has_value(); }
+
+    /// The accepted words, in the order the set was created with
+    const std::vector<std::string>& words() const noexcept;
+    std::size_t                     size() const noexcept { return words().size(); }
+
+    /// A comma-separated list of the accepted words, for diagnostics and help text
+    std::string joined(std::string_view sep = ", ") const noexcept;
+
+    /// The number of bytes used by the words and the hash table
+    std::size_t memory_usage() const noexcept;
+};
+
+/**
+ * @brief A choice_set that maps each accepted word to a value (e.g. an enumerator)
+ */
+template <typename T>
+class choice_map {
+    choice_set     _set;
+    std::vector<T> _values;
+
+    static std::vector<std::string> _keys(std::initializer_list<std::pair<std::string_view, T>> l) {
+        std::vector<std::string> ret;
+        for (auto& [key, _] : l) {
+            ret.emplace_back(key);
+        }
+        return ret;
+    }
+
+public:
+    choice_map(std::initializer_list<std::pair<std::string_view, T>> pairs)
+        : _set(_keys(pairs)) {
+        for (auto& [_, value] : pairs) {
+            _values.push_back(value);
+        }
+    }
+
+    /// The words that are accepted, for use as params::for_argument::choices
+    const choice_set& choices() const noexcept { return _set; }
+
+    /// Get the value that is mapped to the given word, or nullptr
+    const T* find(std::string_view word) const noexcept {
+        auto idx = _set.find(word);
+        return idx ? &_values[*idx] : nullptr;
+    }
+
+    /**
+     * @brief Create an argument action that stores the value mapped to the given word.
+     *
+     * The argument must also be given choices(), so that unknown words are rejected before the
+     * action is invoked.
+     */
+    template <typename Dest>
+    auto store(Dest& out) const noexcept {
+        return [map = *this, &out](std::string_view, std::string_view word) {
+            if (auto found = map.find(word)) {
+                out = *found;
+            }
+        };
+    }
+};
+
+}  // namespace debate
@@ -0,0 +1,71 @@
+#include "./choice_set.hpp"
+
+#include "./error.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using debate::choice_set;
+
+TEST_CASE("Look up words in a choice_set") {
+    choice_set levels{"trace", "debug", "info", "warn", "error", "critical"};
+    CHECK(levels.size() == 6);
+    CHECK(levels.find("trace") == 0);
+    CHECK(levels.find("info") == 2);
+    CHECK(levels.find("critical") == 5);
+    CHECK_FALSE(levels.find("inf").has_value());
+    CHECK_FALSE(levels.find("").has_value());
+    CHECK_FALSE(levels.contains("INFO"));
+    CHECK(levels.joined() == "trace, debug, info, warn, error, critical");
+
+    choice_set single{""};
+    CHECK(single.find("") == 0);
+    CHECK_FALSE(single.contains("x"));
+}
+
+TEST_CASE("Large choice_set") {
+    std::vector<std::string> words;
+    for (int i = 0; i < 2000; ++i) {
+        words.push_back("region-" + std::to_string(i));
+    }
+    choice_set regions{words};
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        CHECK(regions.find(words[i]) == i);
+    }
+    CHECK_FALSE(regions.contains("region-2000"));
+    CHECK_FALSE(regions.contains("region-"));
+}
+
+TEST_CASE("choice_set with words whose hashes collide") {
+    // These two words have the same 64-bit FNV-1a hash, so no table can separate them
+    choice_set words{"c5bde799c2362419", "a1a9a9bf38687075", "other"};
+    CHECK(words.find("c5bde799c2362419") == 0);
+    CHECK(words.find("a1a9a9bf38687075") == 1);
+    CHECK(words.find("other") == 2);
+    CHECK_FALSE(words.contains("a1a9a9bf3868707"));
+    CHECK_FALSE(words.contains("zzz"));
+}
+
+TEST_CASE("Invalid choice_sets") {
+    CHECK_THROWS_AS(choice_set({"a", "b", "a"}), debate::invalid_argument_params);
+    CHECK_THROWS_AS(choice_set(std::vector<std::string>{}), debate::invalid_argument_params);
+}
+
+TEST_CASE("Map choices to values") {
+    enum class codec { none, gzip, zstd };
+    debate::choice_map<codec> codecs = {
+        {"none", codec::none},
+        {"gzip", codec::gzip},
+        {"zstd", codec::zstd},
+    };
+    REQUIRE(codecs.find("zstd"));
+    CHECK(*codecs.find("zstd") == codec::zstd);
+    CHECK(codecs.find("lz4") == nullptr);
+    CHECK(codecs.choices().size() == 3);
+
+    codec got    = codec::none;
+    auto  action = codecs.store(got);
+    action("--codec", "gzip");
+    CHECK(got == codec::gzip);
+}
@@ -0,0 +1,101 @@
+#include "./cmdline.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace debate;
+
+void cmdline_buffer::_split() noexcept {
+    _words.clear();
+    std::string_view rest = _bytes;
+    for (auto pos = rest.find('\0'); pos != rest.npos; pos = rest.find('\0')) {
+        _words.push_back(rest.substr(0, pos));
+        rest.remove_prefix(pos + 1);
+    }
+    if (not rest.empty()) {
+        // The last word was not terminated
+        _words.push_back(rest);
+    }
+}
+
+void cmdline_buffer::assign(std::string_view bytes) {
+    _bytes.assign(bytes);
+    _split();
+}
+
+#ifdef _WIN32
+
+bool cmdline_buffer::_load(const char*) {
+    throw std::system_error(std::make_error_code(std::errc::not_supported),
+                            "Loading command lines is not supported on this platform");
+}
+
+bool cmdline_buffer::load_file(const std::filesystem::path&) { return _load(nullptr); }
+
+#else
+
+bool cmdline_buffer::_load(const char* path) {
+    _bytes.clear();
+    _words.clear();
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT or errno == ESRCH) {
+            return false;
+        }
+        throw std::system_error(std::error_code(errno, std::system_category()),
+                                "Failed to open a command line file");
+    }
+    // Files in /proc report a size of zero, so read until the end instead of asking for the size.
+    // The buffer is grown to its capacity, so that a warm buffer needs no further allocation.
+    std::size_t size = 0;
+    while (true) {
+        if (size == _bytes.size()) {
+            _bytes.resize(std::max<std::size_t>(_bytes.capacity(), size + 4096));
+        }
+        auto n = ::read(fd, _bytes.data() + size, _bytes.size() - size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            auto err = errno;
+            ::close(fd);
+            _bytes.clear();
+            if (err == ESRCH) {
+                // The process exited while we were reading
+                return false;
+            }
+            throw std::system_error(std::error_code(err, std::system_category()),
+                                    "Failed to read a command line file");
+        }
+        if (n == 0) {
+            break;
+        }
+        size += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+    _bytes.resize(size);
+    _split();
+    return true;
+}
+
+bool cmdline_buffer::load_file(const std::filesystem::path& fpath) {
+    return _load(fpath.c_str());
+}
+
+#endif
+
+bool cmdline_buffer::load_process(long pid) {
+    // Build the path without allocating
+    char path[64] = "/proc/";
+    auto end      = std::to_chars(path + 6, path + sizeof path - 9, pid).ptr;
+    std::string_view("/cmdline").copy(end, 8);
+    end[8] = '\0';
+    return _load(path);
+}
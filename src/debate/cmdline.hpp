@@ -0,0 +1,64 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace debate {
+
+/**
+ * @brief Reusable storage for a command line in the NUL-delimited format of
+ * `/proc/<pid>/cmdline`.
+ *
+ * The words are views into the buffer, so splitting copies nothing, and the buffer and the word
+ * list keep their capacity between loads. A program that classifies many processes can load each
+ * command line into the same buffer and parse args() with a parse_context (and, if it only needs
+ * to know whether the words are well-formed, with params::for_parse::run_actions disabled),
+ * without allocating once the buffer and the context have warmed up.
+ *
+ * Loading a new command line invalidates the views of the previous one.
+ */
+class cmdline_buffer {
+    std::string                   _bytes;
+    std::vector<std::string_view> _words;
+
+    void _split() noexcept;
+    bool _load(const char* path);
+
+public:
+    /// Copy the given NUL-delimited words into the buffer. The final NUL may be omitted.
+    void assign(std::string_view bytes);
+
+    /**
+     * @brief Load the command line of the process with the given ID from `/proc`.
+     *
+     * The command line of a kernel thread or of a zombie process is empty.
+     *
+     * @return false if the process does not exist (e.g. it has exited), leaving the buffer empty
+     * @throws std::system_error if the command line cannot be read for another reason
+     */
+    bool load_process(long pid);
+
+    /**
+     * @brief Load a file that holds NUL-delimited words.
+     *
+     * @return false if the file does not exist, leaving the buffer empty
+     * @throws std::system_error if the file cannot be read for another reason
+     */
+    bool load_file(const std::filesystem::path& fpath);
+
+    /// Every word, including the program name
+    std::span<const std::string_view> words() const noexcept { return _words; }
+    /// The program name, or an empty string if there are no words
+    std::string_view program() const noexcept {
+        return _words.empty() ? std::string_view{} : _words.front();
+    }
+    /// The words after the program name, to be given to argument_parser::parse_args()
+    std::span<const std::string_view> args() const noexcept {
+        return words().subspan(_words.empty() ? 0 : 1);
+    }
+};
+
+}  // namespace debate
@@ -0,0 +1,75 @@
+#include "./cmdline.hpp"
+
+#include <debate/argument_parser.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std::literals;
+
+TEST_CASE("Split a NUL-delimited command line") {
+    debate::cmdline_buffer buf;
+    buf.assign("tool\0--jobs\0" "4\0\0last\0"sv);
+    CHECK(buf.program() == "tool");
+    CHECK(std::vector<std::string_view>(buf.args().begin(), buf.args().end())
+          == std::vector<std::string_view>{"--jobs", "4", "", "last"});
+
+    // The final NUL is optional
+    buf.assign("tool\0x"sv);
+    CHECK(buf.words().size() == 2);
+    CHECK(buf.args().front() == "x");
+
+    buf.assign(""sv);
+    CHECK(buf.words().empty());
+    CHECK(buf.args().empty());
+    CHECK(buf.program().empty());
+}
+
+TEST_CASE("Classify command lines loaded from files") {
+    debate::argument_parser parser;
+    int                     n_actions = 0;
+    parser.add_argument({
+        .names  = {"--jobs", "-j"},
+        .action = [&](auto, auto) { ++n_actions; },
+    });
+    parser.add_argument({.names = {"input"}, .action = debate::null_action});
+
+    auto path = std::filesystem::temp_directory_path() / "debate-test-cmdline";
+    std::ofstream{path, std::ios::binary} << "make\0-j\0" "8\0main.c\0"sv;
+
+    debate::cmdline_buffer buf;
+    debate::parse_context  ctx;
+    REQUIRE(buf.load_file(path));
+    CHECK(buf.program() == "make");
+    parser.parse_args(buf.args(), {.context = &ctx, .run_actions = false});
+    CHECK(n_actions == 0);
+
+    std::ofstream{path, std::ios::binary} << "make\0--bogus\0"sv;
+    REQUIRE(buf.load_file(path));
+    CHECK_THROWS_AS(parser.parse_args(buf.args(), {.context = &ctx, .run_actions = false}),
+                    debate::unknown_argument);
+
+    std::filesystem::remove(path);
+    CHECK_FALSE(buf.load_file(path));
+    CHECK(buf.words().empty());
+}
+
+#ifdef __linux__
+
+TEST_CASE("Load the command line of a process") {
+    debate::cmdline_buffer buf;
+    REQUIRE(buf.load_process(::getpid()));
+    CHECK_FALSE(buf.program().empty());
+    // No process has a negative ID
+    CHECK_FALSE(buf.load_process(-1));
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include "./config_file.hpp"
+
+#include "./detail/mapped_file.hpp"
+#include "./error.hpp"
+
+#include <boost/leaf/exception.hpp>
+#include <boost/leaf/on_error.hpp>
+#include <neo/tokenize.hpp>
+
+#include <vector>
+
+using namespace debate;
+using strv = std::string_view;
+
+struct debate::detail::config_file_data {
+    std::string              filepath;
+    detail::mapped_file      mapping;
+    std::string              owned_content;
+    strv                     content;
+    std::vector<config_entry> entries;
+};
+
+const detail::config_file_data& config_file::_data() const noexcept { return *this; }
+
+std::span<const config_entry> config_file::entries() const noexcept { return _data().entries; }
+const std::string&            config_file::filepath() const noexcept { return _data().filepath; }
+
+config_file config_file::open(const std::filesystem::path& fpath) {
+    auto _ = boost::leaf::on_error(e_config_file{fpath.string()});
+    config_file                ret;
+    detail::config_file_data& data = ret;
+    data.filepath                  = fpath.string();
+    data.mapping                   = detail::mapped_file{fpath};
+    data.content                   = data.mapping.view();
+    ret._parse();
+    return ret;
+}
+
+config_file config_file::from_string(std::string content) {
+    config_file                ret;
+    detail::config_file_data& data = ret;
+    data.owned_content             = std::move(content);
+    data.content                   = data.owned_content;
+    ret._parse();
+    return ret;
+}
+
+void config_file::_parse() {
+    detail::config_file_data& data = *this;
+
+    strv        section;
+    strv        remaining = data.content;
+    std::size_t line_num  = 0;
+    while (not remaining.empty()) {
+        ++line_num;
+        auto nl   = remaining.find('\n');
+        strv line = remaining.substr(0, nl);
+        remaining.remove_prefix(nl == strv::npos ? remaining.size() : nl + 1);
+
+        line = neo::trim(line);
+        if (line.empty() or line.front() == '#' or line.front() == ';') {
+            continue;
+        }
+        auto _ = boost::leaf::on_error(e_config_line{line_num});
+        if (line.front() == '[') {
+            if (not line.ends_with(']')) {
+                BOOST_LEAF_THROW_EXCEPTION(
+                    invalid_config_syntax{"Section header is missing a closing bracket"});
+            }
+            section = neo::trim(line.substr(1, line.size() - 2));
+            continue;
+        }
+
+        auto eq    = line.find('=');
+        strv key   = neo::trim(line.substr(0, eq));
+        strv value = eq == strv::npos ? strv{"true"} : neo::trim(line.substr(eq + 1));
+        if (key.empty()) {
+            BOOST_LEAF_THROW_EXCEPTION(invalid_config_syntax{"Setting has an empty key"});
+        }
+        if (value.starts_with('"')) {
+            if (value.size() < 2 or not value.ends_with('"')) {
+                BOOST_LEAF_THROW_EXCEPTION(
+                    invalid_config_syntax{"Quoted value is missing a closing quote"});
+            }
+            value = value.substr(1, value.size() - 2);
+        }
+        data.entries.push_back(config_entry{
+            .section = section,
+            .key     = key,
+            .value   = value,
+            .line    = line_num,
+        });
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <neo/shared.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace debate {
+
+/**
+ * @brief A single "key = value" setting from a config_file.
+ *
+ * All strings are views into the config_file's storage.
+ */
+struct config_entry {
+    /// The section that contains the setting. Empty for the top-level section.
+    std::string_view section;
+    std::string_view key;
+    std::string_view value;
+    /// The 1-based line number where the setting appears
+    std::size_t line;
+};
+
+namespace detail {
+
+struct config_file_data;
+
+}  // namespace detail
+
+/**
+ * @brief A parsed configuration file that can supply arguments to argument_parser::parse_args().
+ *
+ * The syntax is a minimal INI-like format:
+ *
+ *      # Comments begin with '#' or ';'
+ *      jobs = 4
+ *      verbose
+ *
+ *      [build.release]
+ *      output = "some file"
+ *
+ * A key names an argument by its long name without the leading "--", or by its positional name.
+ * A key without a value is equivalent to "key = true". Sections name a subparser by its path of
+ * subcommand names, separated by dots. Keys before the first section belong to the top-level
+ * parser. A value may be wrapped in double quotes to preserve leading or trailing whitespace.
+ *
+ * Copies of a config_file share the same underlying storage.
+ */
+class config_file : neo::shared_state<config_file, detail::config_file_data> {
+    const detail::config_file_data& _data() const noexcept;
+    void                            _parse();
+
+    config_file() = default;
+
+public:
+    /**
+     * @brief Map the given file into memory and parse it. Entries refer directly into the
+     * mapping.
+     *
+     * @throws std::system_error if the file cannot be opened or mapped
+     * @throws invalid_config_syntax (with e_config_file and e_config_line) for bad syntax
+     */
+    static config_file open(const std::filesystem::path& fpath);
+
+    /**
+     * @brief Parse the given configuration text, taking ownership of it.
+     */
+    static config_file from_string(std::string content);
+
+    std::span<const config_entry> entries() const noexcept;
+    /// The path to the file, or an empty string if it was not loaded from a file
+    const std::string& filepath() const noexcept;
+};
+
+/// Error data: The path of the config file that was being handled
+struct e_config_file {
+    std::string value;
+};
+
+/// Error data: The line number within a config file that was being handled
+struct e_config_line {
+    std::size_t value;
+};
+
+}  // namespace debate
@@ -0,0 +1,66 @@
+#include "./config_file.hpp"
+
+#include "./error.hpp"
+
+#include <boost/leaf/handle_errors.hpp>
+#include <catch2/catch.hpp>
+
+#include <fstream>
+
+using debate::config_file;
+
+TEST_CASE("Parse a config string") {
+    auto cfg = config_file::from_string(R"(
+        # A comment
+        jobs = 4
+        ; Another comment
+        verbose
+
+        [build.release]
+        output = "  spaced  "
+        empty =
+    )");
+
+    auto entries = cfg.entries();
+    REQUIRE(entries.size() == 4);
+    CHECK(entries[0].section == "");
+    CHECK(entries[0].key == "jobs");
+    CHECK(entries[0].value == "4");
+    CHECK(entries[0].line == 3);
+    CHECK(entries[1].key == "verbose");
+    CHECK(entries[1].value == "true");
+    CHECK(entries[2].section == "build.release");
+    CHECK(entries[2].key == "output");
+    CHECK(entries[2].value == "  spaced  ");
+    CHECK(entries[3].key == "empty");
+    CHECK(entries[3].value == "");
+}
+
+TEST_CASE("Config syntax errors") {
+    auto bad = GENERATE(as<std::string>{}, "[unclosed", "= value", "key = \"unclosed");
+    boost::leaf::try_catch(
+        [&] {
+            config_file::from_string("\n" + bad);
+            FAIL_CHECK("Did not throw");
+        },
+        [&](debate::invalid_config_syntax, debate::e_config_line line) {
+            CHECK(line.value == 2);
+        });
+}
+
+TEST_CASE("Map a config file") {
+    auto tmp = std::filesystem::temp_directory_path() / "debate-config-test.ini";
+    {
+        std::ofstream out{tmp, std::ios::binary};
+        out << "name = value\n[sub]\nother=thing";
+    }
+    auto cfg = config_file::open(tmp);
+    CHECK(cfg.filepath() == tmp.string());
+    REQUIRE(cfg.entries().size() == 2);
+    CHECK(cfg.entries()[0].value == "value");
+    CHECK(cfg.entries()[1].section == "sub");
+    CHECK(cfg.entries()[1].value == "thing");
+    std::filesystem::remove(tmp);
+
+    CHECK_THROWS_AS(config_file::open(tmp), std::system_error);
+}
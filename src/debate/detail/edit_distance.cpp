@@ -0,0 +1,124 @@
+#include "./edit_distance.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace debate;
+using detail::edit_distance_matcher;
+
+namespace {
+
+std::size_t abs_diff(std::size_t a, std::size_t b) noexcept { return a > b ? a - b : b - a; }
+
+/// Two-row dynamic programming edit distance, for patterns too long for one machine word
+std::size_t dp_distance(std::string_view a, std::string_view b, std::size_t max) {
+    std::vector<std::size_t> prev(b.size() + 1);
+    std::vector<std::size_t> cur(b.size() + 1);
+    std::iota(prev.begin(), prev.end(), std::size_t{0});
+    for (std::size_t i = 1; i <= a.size(); ++i) {
+        cur[0]           = i;
+        std::size_t best = cur[0];
+        for (std::size_t j = 1; j <= b.size(); ++j) {
+            auto subst = prev[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            cur[j]     = (std::min)({prev[j] + 1, cur[j - 1] + 1, subst});
+            best       = (std::min)(best, cur[j]);
+        }
+        if (best > max) {
+            // Every cell in the row already exceeds the limit
+            return max + 1;
+        }
+        std::swap(prev, cur);
+    }
+    return (std::min)(prev[b.size()], max + 1);
+}
+
+}  // namespace
+
+edit_distance_matcher::edit_distance_matcher(std::string_view pattern) noexcept
+    : _pattern(pattern) {
+    if (pattern.size() > 64) {
+        return;
+    }
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        _peq[static_cast<unsigned char>(pattern[i])] |= std::uint64_t{1} << i;
+    }
+}
+
+std::size_t edit_distance_matcher::distance(std::string_view text, std::size_t max) const {
+    const auto m = _pattern.size();
+    // The distance is at least the difference in length
+    if (abs_diff(m, text.size()) > max) {
+        return max + 1;
+    }
+    if (m == 0) {
+        return text.size();
+    }
+    if (m > 64) {
+        return dp_distance(_pattern, text, max);
+    }
+
+    // Vertical deltas of the current DP column, as bit vectors of +1 and -1
+    std::uint64_t pv    = ~std::uint64_t{0};
+    std::uint64_t mv    = 0;
+    std::size_t   score = m;
+
+    const std::uint64_t high_bit = std::uint64_t{1} << (m - 1);
+    for (std::size_t j = 0; j < text.size(); ++j) {
+        const std::uint64_t eq = _peq[static_cast<unsigned char>(text[j])];
+        const std::uint64_t xv = eq | mv;
+        const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        std::uint64_t       ph = mv | ~(xh | pv);
+        std::uint64_t       mh = pv & xh;
+        if (ph & high_bit) {
+            ++score;
+        } else if (mh & high_bit) {
+            --score;
+        }
+        // The top row of the DP matrix increases by one in each column
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        // The score can decrease by at most one per remaining character
+        const auto remaining = text.size() - j - 1;
+        if (score > max + remaining) {
+            return max + 1;
+        }
+    }
+    return (std::min)(score, max + 1);
+}
+
+std::vector<std::string> detail::rank_suggestions(std::string_view                  given,
+                                                  std::span<const std::string_view> candidates,
+                                                  std::size_t max_results) {
+    // Allow roughly one typo for every three characters
+    const std::size_t max_distance = given.size() / 3 + 1;
+
+    struct scored {
+        std::size_t      distance;
+        std::string_view name;
+
+        constexpr auto operator<=>(const scored&) const noexcept = default;
+    };
+
+    edit_distance_matcher matcher{given};
+    std::vector<scored>   hits;
+    for (auto cand : candidates) {
+        auto dist = matcher.distance(cand, max_distance);
+        if (dist == 0 or dist > max_distance or dist >= cand.size()) {
+            continue;
+        }
+        hits.push_back(scored{dist, cand});
+    }
+    std::sort(hits.begin(), hits.end());
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+
+    std::vector<std::string> ret;
+    for (auto& hit : hits) {
+        if (ret.size() == max_results) {
+            break;
+        }
+        ret.emplace_back(hit.name);
+    }
+    return ret;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace debate::detail {
+
+/**
+ * @brief Computes the Levenshtein distance between a fixed pattern and many candidate strings.
+ *
+ * For patterns of up to 64 characters this uses the bit-parallel algorithm of Myers (in the
+ * formulation by Hyyrö), which processes one candidate character per step regardless of the
+ * pattern length. The character table is built once in the constructor and reused for every
+ * candidate. Longer patterns fall back to the classic dynamic-programming algorithm.
+ */
+class edit_distance_matcher {
+    std::string_view                _pattern;
+    std::array<std::uint64_t, 256> _peq{};
+
+public:
+    explicit edit_distance_matcher(std::string_view pattern) noexcept;
+
+    /**
+     * @brief Compute the edit distance from the pattern to the given text.
+     *
+     * @param max The largest distance of interest. If the distance is certainly greater than
+     * `max`, returns `max + 1` (possibly without computing the exact distance).
+     */
+    std::size_t distance(std::string_view text, std::size_t max) const;
+};
+
+/**
+ * @brief Select and rank the candidates that are plausible corrections of the given word
+ *
+ * @return The closest candidates, nearest first, with ties ordered by name. Exact matches and
+ * candidates that are too far away to be a plausible typo are omitted.
+ */
+std::vector<std::string> rank_suggestions(std::string_view                   given,
+                                          std::span<const std::string_view> candidates,
+                                          std::size_t max_results = 5);
+
+}  // namespace debate::detail
@@ -0,0 +1,63 @@
+#include "./edit_distance.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+using debate::detail::edit_distance_matcher;
+
+namespace {
+
+std::size_t reference_distance(std::string_view a, std::string_view b) {
+    std::vector<std::size_t> prev(b.size() + 1);
+    std::vector<std::size_t> cur(b.size() + 1);
+    std::iota(prev.begin(), prev.end(), std::size_t{0});
+    for (std::size_t i = 1; i <= a.size(); ++i) {
+        cur[0] = i;
+        for (std::size_t j = 1; j <= b.size(); ++j) {
+            cur[j] = (std::min)(
+                {prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1)});
+        }
+        std::swap(prev, cur);
+    }
+    return prev[b.size()];
+}
+
+}  // namespace
+
+TEST_CASE("Edit distance") {
+    auto [pattern, text, expect] = GENERATE(table<std::string, std::string, std::size_t>({
+        {"", "", 0},
+        {"abc", "", 3},
+        {"", "abc", 3},
+        {"--verbose", "--verbose", 0},
+        {"--verbsoe", "--verbose", 2},
+        {"--verbos", "--verbose", 1},
+        {"--vrebose", "--verbose", 2},
+        {"kitten", "sitting", 3},
+        {"flaw", "lawn", 2},
+        {std::string(70, 'a'), std::string(70, 'a'), 0},
+        {std::string(70, 'a'), std::string(68, 'a') + "bb", 2},
+        {std::string(64, 'x'), std::string(63, 'x') + "y", 1},
+    }));
+    INFO("Pattern: " << pattern);
+    INFO("Text: " << text);
+    CHECK(reference_distance(pattern, text) == expect);
+    edit_distance_matcher m{pattern};
+    CHECK(m.distance(text, 100) == expect);
+    // Limited search either finds the exact distance or reports "too far"
+    CHECK(m.distance(text, 1) == (std::min)(expect, std::size_t{2}));
+}
+
+TEST_CASE("Rank suggestions") {
+    std::vector<std::string_view> names
+        = {"--verbose", "--version", "--output", "--outputs", "-v", "--jobs"};
+    CHECK(debate::detail::rank_suggestions("--verbos", names)
+          == std::vector<std::string>{"--verbose", "--version"});
+    CHECK(debate::detail::rank_suggestions("--otput", names)
+          == std::vector<std::string>{"--output", "--outputs"});
+    CHECK(debate::detail::rank_suggestions("--frobnicate", names).empty());
+    // Exact matches are never suggested
+    CHECK(debate::detail::rank_suggestions("--jobs", names).empty());
+}
@@ -0,0 +1,149 @@
+#include "./mapped_file.hpp"
+
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace debate;
+using detail::mapped_file;
+
+#ifdef _WIN32
+
+mapped_file::mapped_file(const std::filesystem::path& fpath) {
+    auto file = ::CreateFileW(fpath.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::system_error(std::error_code(static_cast<int>(::GetLastError()),
+                                                std::system_category()),
+                                "Failed to open file for mapping");
+    }
+    _file_handle = file;
+    LARGE_INTEGER size;
+    if (not ::GetFileSizeEx(file, &size)) {
+        auto err = ::GetLastError();
+        _close();
+        throw std::system_error(std::error_code(static_cast<int>(err), std::system_category()),
+                                "Failed to get the size of a mapped file");
+    }
+    _size = static_cast<std::size_t>(size.QuadPart);
+    if (_size == 0) {
+        return;
+    }
+    _mapping_handle = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mapping_handle == nullptr) {
+        auto err = ::GetLastError();
+        _close();
+        throw std::system_error(std::error_code(static_cast<int>(err), std::system_category()),
+                                "Failed to create a file mapping");
+    }
+    _data = static_cast<const char*>(::MapViewOfFile(_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (_data == nullptr) {
+        auto err = ::GetLastError();
+        _close();
+        throw std::system_error(std::error_code(static_cast<int>(err), std::system_category()),
+                                "Failed to map a view of a file");
+    }
+}
+
+void mapped_file::_close() noexcept {
+    if (_data) {
+        ::UnmapViewOfFile(_data);
+    }
+    if (_mapping_handle) {
+        ::CloseHandle(_mapping_handle);
+    }
+    if (_file_handle) {
+        ::CloseHandle(_file_handle);
+    }
+    _data           = nullptr;
+    _size           = 0;
+    _mapping_handle = nullptr;
+    _file_handle    = nullptr;
+}
+
+mapped_file::mapped_file(mapped_file&& o) noexcept
+    : _data(std::exchange(o._data, nullptr))
+    , _size(std::exchange(o._size, 0))
+    , _file_handle(std::exchange(o._file_handle, nullptr))
+    , _mapping_handle(std::exchange(o._mapping_handle, nullptr)) {}
+
+mapped_file& mapped_file::operator=(mapped_file&& o) noexcept {
+    if (this != &o) {
+        _close();
+        _data           = std::exchange(o._data, nullptr);
+        _size           = std::exchange(o._size, 0);
+        _file_handle    = std::exchange(o._file_handle, nullptr);
+        _mapping_handle = std::exchange(o._mapping_handle, nullptr);
+    }
+    return *this;
+}
+
+#else
+
+mapped_file::mapped_file(const std::filesystem::path& fpath) {
+    int fd = ::open(fpath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(std::error_code(errno, std::system_category()),
+                                "Failed to open file for mapping");
+    }
+    struct ::stat st;
+    if (::fstat(fd, &st) != 0) {
+        auto err = errno;
+        ::close(fd);
+        throw std::system_error(std::error_code(err, std::system_category()),
+                                "Failed to get the size of a mapped file");
+    }
+    _size = static_cast<std::size_t>(st.st_size);
+    if (_size == 0) {
+        ::close(fd);
+        return;
+    }
+    void* addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    auto  err  = errno;
+    // The mapping remains valid after the descriptor is closed
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        _size = 0;
+        throw std::system_error(std::error_code(err, std::system_category()),
+                                "Failed to map file");
+    }
+    _data = static_cast<const char*>(addr);
+}
+
+void mapped_file::_close() noexcept {
+    if (_data) {
+        ::munmap(const_cast<char*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+}
+
+mapped_file::mapped_file(mapped_file&& o) noexcept
+    : _data(std::exchange(o._data, nullptr))
+    , _size(std::exchange(o._size, 0)) {}
+
+mapped_file& mapped_file::operator=(mapped_file&& o) noexcept {
+    if (this != &o) {
+        _close();
+        _data = std::exchange(o._data, nullptr);
+        _size = std::exchange(o._size, 0);
+    }
+    return *this;
+}
+
+#endif
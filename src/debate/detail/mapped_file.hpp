@@ -0,0 +1,34 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+namespace debate::detail {
+
+/**
+ * @brief A read-only memory mapping of an entire file.
+ *
+ * Move-only. An empty file produces an empty view without creating a mapping.
+ */
+class mapped_file {
+    const char* _data = nullptr;
+    std::size_t _size = 0;
+#ifdef _WIN32
+    void* _file_handle    = nullptr;
+    void* _mapping_handle = nullptr;
+#endif
+
+    void _close() noexcept;
+
+public:
+    mapped_file() = default;
+    explicit mapped_file(const std::filesystem::path& fpath);
+
+    mapped_file(mapped_file&& o) noexcept;
+    mapped_file& operator=(mapped_file&& o) noexcept;
+    ~mapped_file() { _close(); }
+
+    std::string_view view() const noexcept { return std::string_view(_data, _size); }
+};
+
+}  // namespace debate::detail
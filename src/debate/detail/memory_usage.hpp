@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace debate::detail {
+
+/// The heap memory owned by a string, or zero if its characters are stored in the object itself
+template <typename Char, typename Traits, typename Alloc>
+std::size_t heap_bytes(const std::basic_string<Char, Traits, Alloc>& s) noexcept {
+    auto obj  = reinterpret_cast<const char*>(&s);
+    auto data = reinterpret_cast<const char*>(s.data());
+    if (not std::less<>{}(data, obj) and std::less<>{}(data, obj + sizeof(s))) {
+        return 0;
+    }
+    return (s.capacity() + 1) * sizeof(Char);
+}
+
+}  // namespace debate::detail
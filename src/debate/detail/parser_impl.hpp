@@ -0,0 +1,255 @@
+#pragma once
+
+#include "../argument_parser.hpp"
+#include "./string_pool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace debate::detail {
+
+/// State for a subparser that is only constructed on first use (e.g. when loaded from a snapshot)
+struct lazy_subparser {
+    std::once_flag                   once;
+    std::function<argument_parser()> load;
+    std::optional<argument_parser>   parser{};
+    /// Set (with release ordering) once `parser` has been emplaced, so that it can be checked
+    /// without racing a concurrent load
+    std::atomic<bool> done{false};
+};
+
+struct subparser {
+    category cat;
+    /// The subparser. Empty if the subparser is loaded lazily.
+    std::optional<argument_parser> parser;
+    /// Non-null if the subparser is loaded lazily.
+    std::shared_ptr<lazy_subparser> lazy{};
+
+    const argument_parser& get() const {
+        if (lazy) {
+            std::call_once(lazy->once, [&] {
+                lazy->parser.emplace(lazy->load());
+                lazy->done.store(true, std::memory_order_release);
+            });
+            return *lazy->parser;
+        }
+        return *parser;
+    }
+
+    /// The subparser, or null if it is loaded lazily and has not been loaded yet
+    const argument_parser* loaded() const noexcept {
+        if (lazy) {
+            return lazy->done.load(std::memory_order_acquire) ? &*lazy->parser : nullptr;
+        }
+        return &*parser;
+    }
+};
+
+using parser_map = std::pmr::map<std::pmr::string, subparser, std::less<>>;
+
+/// An entry in a name index, referring to an argument by its ordinal within its parser
+struct name_entry {
+    std::string_view name;
+    std::size_t      ordinal;
+};
+
+/// A constraint between the arguments of a single parser
+struct constraint_impl {
+    params::for_constraint        def;
+    std::pmr::vector<std::size_t> ordinals;
+};
+
+struct subparser_group_impl {
+    parser_map  parsers;
+    std::string title;
+    opt_string  description;
+    bool        required;
+
+    std::weak_ptr<argument_parser_impl> parent;
+
+    argument_action action;
+};
+
+struct argument_parser_impl {
+    params::for_argument_parser params;
+
+    std::string                         name;
+    std::weak_ptr<argument_parser_impl> parent;
+
+    /// Storage for the names and help text of arguments. Shared by every parser in the tree, and
+    /// only created when it is first needed (see pool()).
+    std::shared_ptr<string_pool> strings{};
+
+    // The tables below are allocated from `params.memory`, along with the parser itself (see
+    // create()).
+
+    /// Command-line arguments attached to this parser
+    std::pmr::vector<debate::argument> arguments{memory()};
+    /// Sub-parsers attached to this parser. Only non-null after a call to add_subparsers()
+    std::optional<subparser_group_impl> subparsers{};
+    /// Argument groups attached to this parser. Their arguments follow `arguments` in ordinal
+    /// order. (A group is itself stored as an argument_parser_impl that is never parsed directly.)
+    std::pmr::vector<std::shared_ptr<const argument_parser_impl>> groups{memory()};
+
+    // Lookup indexes over `arguments`, maintained by add_argument(). Names are views into the
+    // argument objects, which are never removed. If more than one argument claims a name, the
+    // first one added wins, just as if `arguments` were searched in order.
+
+    /// Long names (including the leading "--") to argument ordinals
+    std::pmr::map<std::string_view, std::size_t> long_names{memory()};
+    /// Short names (including the leading "-"), keyed by their first letter, in definition order
+    std::pmr::multimap<char, name_entry> short_names{memory()};
+    /// Ordinals of positional arguments, in definition order
+    std::pmr::vector<std::size_t> positionals{memory()};
+
+    // Constraints are checked with bitmasks over `constraints`, so the cost of checking does not
+    // depend on the number of arguments. A dependency with several prerequisites is stored as one
+    // constraint per prerequisite.
+
+    std::pmr::vector<constraint_impl> constraints{memory()};
+    /// The number of 64-bit words in a bitmask over `constraints`
+    std::size_t constraint_words = 0;
+    /// The constraints that need at least one of their arguments to be given
+    std::pmr::vector<std::uint64_t> required_constraints{memory()};
+    /// For each argument (by ordinal) with any constraints, one bitmask for each mask_role
+    std::pmr::vector<std::uint64_t> constraint_masks{memory()};
+    /// The number of arguments that have an entry in constraint_masks
+    std::size_t n_constrained = 0;
+
+    /// Create a parser whose tables (and the parser itself) are allocated from `p.memory`
+    static std::shared_ptr<argument_parser_impl> create(params::for_argument_parser p) {
+        auto memory = p.memory ? p.memory : std::pmr::get_default_resource();
+        return std::allocate_shared<argument_parser_impl>(std::pmr::polymorphic_allocator<>(memory),
+                                                          std::move(p));
+    }
+
+    explicit argument_parser_impl(params::for_argument_parser p)
+        : params(std::move(p)) {}
+
+    /// The resource that the tables of this parser are allocated from
+    std::pmr::memory_resource* memory() const noexcept {
+        return params.memory ? params.memory : std::pmr::get_default_resource();
+    }
+
+    enum mask_role : std::size_t {
+        /// The constraints that are satisfied when the argument is given
+        satisfies,
+        /// The constraints in which the argument excludes all the others
+        excludes,
+        /// The constraints that take effect when the argument is given (for dependencies)
+        triggers,
+        n_mask_roles,
+    };
+
+    std::span<const std::uint64_t> masks_of(std::size_t ordinal, mask_role role) const noexcept {
+        auto offset = (ordinal * n_mask_roles + role) * constraint_words;
+        return std::span(constraint_masks).subspan(offset, constraint_words);
+    }
+
+    void rebuild_constraint_masks() {
+        constraint_words = (constraints.size() + 63) / 64;
+        n_constrained    = arguments.size();
+        required_constraints.assign(constraint_words, 0);
+        constraint_masks.assign(n_constrained * n_mask_roles * constraint_words, 0);
+        auto set_bit = [&](std::size_t ordinal, mask_role role, std::size_t bit) {
+            constraint_masks[(ordinal * n_mask_roles + role) * constraint_words + bit / 64]
+                |= std::uint64_t{1} << (bit % 64);
+        };
+        for (std::size_t idx = 0; idx < constraints.size(); ++idx) {
+            auto& con = constraints[idx];
+            switch (con.def.kind) {
+            case constraint_kind::exactly_one:
+            case constraint_kind::at_least_one:
+                required_constraints[idx / 64] |= std::uint64_t{1} << (idx % 64);
+                break;
+            default:
+                break;
+            }
+            for (auto ordinal : con.ordinals) {
+                switch (con.def.kind) {
+                case constraint_kind::at_most_one:
+                case constraint_kind::exactly_one:
+                    set_bit(ordinal, excludes, idx);
+                    set_bit(ordinal, satisfies, idx);
+                    break;
+                case constraint_kind::at_least_one:
+                    set_bit(ordinal, satisfies, idx);
+                    break;
+                case constraint_kind::dependency:
+                    // The first is the dependent, and the second is its prerequisite
+                    set_bit(ordinal, ordinal == con.ordinals.front() ? triggers : satisfies, idx);
+                    break;
+                }
+            }
+        }
+    }
+
+    void index_argument(std::size_t ordinal) {
+        const argument& arg = arguments[ordinal];
+        if (arg.is_positional()) {
+            positionals.push_back(ordinal);
+            return;
+        }
+        for (std::string_view name : arg.names()) {
+            if (name.starts_with("--")) {
+                long_names.emplace(name, ordinal);
+            } else if (name.size() >= 2) {
+                short_names.emplace(name[1], name_entry{name, ordinal});
+            }
+        }
+    }
+
+    /// The argument tables of this parser: first its own arguments, then each attached group
+    std::size_t n_tables() const noexcept { return groups.size() + 1; }
+    const argument_parser_impl& table(std::size_t t) const noexcept {
+        return t == 0 ? *this : *groups[t - 1];
+    }
+
+    /// The ordinal of the first argument of the given table
+    std::size_t table_base(std::size_t t) const noexcept {
+        std::size_t base = 0;
+        for (std::size_t i = 0; i < t; ++i) {
+            base += table(i).arguments.size();
+        }
+        return base;
+    }
+
+    /// Get the string pool, creating it from `params.memory` if the tree does not have one yet
+    const std::shared_ptr<string_pool>& pool() {
+        if (not strings and params.memory) {
+            strings = std::allocate_shared<string_pool>(
+                std::pmr::polymorphic_allocator<>(params.memory), params.memory);
+        } else if (not strings) {
+            strings = std::make_shared<string_pool>();
+        }
+        return strings;
+    }
+
+    /// Every argument of the parser, including those of attached groups, in ordinal order
+    std::vector<argument> all_arguments() const {
+        std::vector<argument> ret(arguments.begin(), arguments.end());
+        for (auto& grp : groups) {
+            ret.insert(ret.end(), grp->arguments.begin(), grp->arguments.end());
+        }
+        return ret;
+    }
+
+    // nocopy _disable_copy{};
+
+    static argument_parser_impl&       extract(argument_parser& p) noexcept { return *p._impl; }
+    static const argument_parser_impl& extract(const argument_parser& p) noexcept {
+        return *p._impl;
+    }
+};
+
+}  // namespace debate::detail
@@ -0,0 +1,69 @@
+#include "./string_pool.hpp"
+
+#include <cstring>
+#include <utility>
+
+using namespace debate::detail;
+
+namespace {
+
+constexpr std::size_t pool_block_size = 4096;
+
+}  // namespace
+
+string_pool::~string_pool() {
+    for (auto& blk : _blocks) {
+        _memory->deallocate(blk.data, blk.size, 1);
+    }
+}
+
+char* string_pool::_allocate(std::size_t size) {
+    if (size > pool_block_size / 4) {
+        // Large strings get a block of their own, and the current block stays the last one
+        _blocks.push_back({static_cast<char*>(_memory->allocate(size, 1)), size});
+        _block_bytes += size;
+        char* ret = _blocks.back().data;
+        if (_blocks.size() > 1) {
+            std::swap(_blocks.back(), _blocks[_blocks.size() - 2]);
+        } else {
+            _block_size = _block_used = size;
+        }
+        return ret;
+    }
+    if (_blocks.empty() or _block_size - _block_used < size) {
+        _blocks.push_back(
+            {static_cast<char*>(_memory->allocate(pool_block_size, 1)), pool_block_size});
+        _block_size = pool_block_size;
+        _block_used = 0;
+        _block_bytes += pool_block_size;
+    }
+    char* ret = _blocks.back().data + _block_used;
+    _block_used += size;
+    return ret;
+}
+
+std::string_view string_pool::intern(std::string_view s, pooled_kind kind) {
+    std::lock_guard lk{_mutex};
+    auto            found = _index.find(s);
+    if (found != _index.end()) {
+        return *found;
+    }
+    char* ptr = _allocate(s.size());
+    if (not s.empty()) {
+        std::memcpy(ptr, s.data(), s.size());
+    }
+    std::string_view pooled{ptr, s.size()};
+    _index.insert(pooled);
+    _bytes_by_kind[static_cast<int>(kind)] += s.size();
+    return pooled;
+}
+
+std::size_t string_pool::overhead_bytes() const noexcept {
+    std::lock_guard lk{_mutex};
+    auto            string_bytes = _bytes_by_kind[0] + _bytes_by_kind[1];
+    // Each index node holds a view, a cached hash, and a link
+    auto index_bytes = _index.size() * (sizeof(std::string_view) + 2 * sizeof(void*))
+        + _index.bucket_count() * sizeof(void*);
+    return _block_bytes - string_bytes + index_bytes
+        + _blocks.capacity() * sizeof(block);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace debate::detail {
+
+/// The kind of a string in a string_pool, for memory reporting
+enum class pooled_kind {
+    /// Argument names
+    name,
+    /// Help text and metavars
+    text,
+};
+
+/**
+ * @brief Stores each distinct string once, in large blocks.
+ *
+ * Interned strings remain valid and at the same address for the lifetime of the pool. A pool is
+ * shared by every parser of a tree, so that an option name that is defined by thousands of
+ * subcommands is stored once. Interning is thread-safe, since lazily-loaded subparsers may add to
+ * the pool of a tree that is in use.
+ *
+ * The blocks and the index are allocated from the memory resource given at construction, which
+ * must outlive the pool.
+ */
+class string_pool {
+    struct block {
+        char*       data;
+        std::size_t size;
+    };
+
+    std::pmr::memory_resource*                _memory;
+    std::pmr::vector<block>                   _blocks{_memory};
+    std::size_t                               _block_used = 0;
+    std::size_t                               _block_size = 0;
+    std::pmr::unordered_set<std::string_view> _index{_memory};
+    std::size_t                               _bytes_by_kind[2] = {};
+    std::size_t                               _block_bytes      = 0;
+    mutable std::mutex                        _mutex;
+
+    char* _allocate(std::size_t size);
+
+public:
+    explicit string_pool(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : _memory(memory) {}
+    ~string_pool();
+
+    /// Get the pooled copy of the given string, adding it to the pool if needed
+    std::string_view intern(std::string_view s, pooled_kind kind);
+
+    /// The number of string bytes that were first interned as the given kind
+    std::size_t bytes(pooled_kind kind) const noexcept {
+        std::lock_guard lk{_mutex};
+        return _bytes_by_kind[static_cast<int>(kind)];
+    }
+    /// The bytes allocated for the blocks and the index, beyond the string bytes themselves
+    std::size_t overhead_bytes() const noexcept;
+};
+
+}  // namespace debate::detail
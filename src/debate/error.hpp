@@ -36,4 +36,20 @@ struct invalid_argument_value : runtime_error {
     using runtime_error::runtime_error;
 };
 
+struct conflicting_arguments : runtime_error {
+    using runtime_error::runtime_error;
+};
+
+struct invalid_config_syntax : runtime_error {
+    using runtime_error::runtime_error;
+};
+
+struct invalid_snapshot : runtime_error {
+    using runtime_error::runtime_error;
+};
+
+struct invalid_help_index : runtime_error {
+    using runtime_error::runtime_error;
+};
+
 }  // namespace debate
@@ -1,5 +1,6 @@
 #include <debate/argument_parser.hpp>
 #include <debate/error.hpp>
+#include <debate/help_search.hpp>
 
 #include <boost/leaf/handle_errors.hpp>
 #include <neo/tokenize.hpp>
@@ -46,6 +47,21 @@ int main(int argc, char** argv) {
         .category    = debate::advanced,
     });
 
+    enum class color_mode { automatic, always, never };
+    const choice_map<color_mode> color_modes = {
+        {"auto", color_mode::automatic},
+        {"always", color_mode::always},
+        {"never", color_mode::never},
+    };
+    color_mode color = color_mode::automatic;
+    parser.add_argument({
+        .names   = {"--color"},
+        .action  = color_modes.store(color),
+        .choices = color_modes.choices(),
+        .metavar = "<when>",
+        .help    = "Whether to use color in output",
+    });
+
     opt_string echo_message;
     auto       subs = parser.add_subparsers({
               .title       = "Subcommands",
@@ -104,6 +120,11 @@ int main(int argc, char** argv) {
             std::cerr << parser.value.help_string(h.category, progname.value);
             return 0;
         },
+        [&](help_search_request req) {
+            // The index is only built when a user actually searches
+            std::cerr << help_search_string(help_index{parser}.search(req.terms));
+            return 0;
+        },
         [](missing_argument, e_argument_parser parser, e_invoked_as progname, e_argument arg) {
             std::cerr << parser.value.usage_string(debate::general, progname.value) << '\n';
             auto arg_help   = arg.value.help_string();
@@ -119,5 +140,20 @@ int main(int argc, char** argv) {
             std::cerr << parser.value.usage_string(debate::general, progname.value) << '\n';
             std::cerr << neo::ufmt("Missing required subcommand\n");
             return 1;
+        },
+        [](invalid_argument_value err, e_argument_name name, e_valid_choices choices) {
+            std::cerr << neo::ufmt("Invalid value '{}' for '{}' (Expected one of: {})\n",
+                                   err.what(),
+                                   name.value,
+                                   neo::join_text(choices.value, ", "sv));
+            return 1;
+        },
+        [](unknown_argument, e_parsing_word word, e_did_you_mean* suggestions) {
+            std::cerr << neo::ufmt("Unknown argument '{}'\n", word.value);
+            if (suggestions and not suggestions->value.empty()) {
+                std::cerr << neo::ufmt("Did you mean: {}?\n",
+                                       neo::join_text(suggestions->value, ", "sv));
+            }
+            return 1;
         });
 }
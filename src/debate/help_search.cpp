@@ -0,0 +1,469 @@
+#include "./help_search.hpp"
+
+#include "./detail/parser_impl.hpp"
+#include "./detail/reflow.hpp"
+#include "./error.hpp"
+
+#include <neo/tokenize.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+
+using namespace debate;
+using strv = std::string_view;
+using u32  = std::uint32_t;
+
+/**
+ * Image layout. As in parser snapshots, every field is a native-endian u32, so records have no
+ * padding and can be copied in and out with memcpy regardless of the alignment of the image:
+ *
+ *      header
+ *      entry_rec[entry_count]      (arguments and subcommands, in depth-first order)
+ *      term_rec[term_count]        (sorted by term)
+ *      posting_rec[posting_count]  (grouped by term, in entry order)
+ *      char[strings_size]          (string data)
+ */
+
+namespace {
+
+constexpr u32 index_magic   = 0x58'44'49'48;  // "HIDX"
+constexpr u32 index_version = 1;
+
+struct str_ref {
+    u32 offset = 0;
+    u32 size   = 0;
+};
+
+struct header {
+    u32 magic;
+    u32 version;
+    u32 entry_count;
+    u32 term_count;
+    u32 posting_count;
+    u32 strings_size;
+};
+
+struct entry_rec {
+    /// The subcommand names leading to the entry, separated by spaces
+    str_ref path;
+    /// The preferred name of the argument. Empty for a subcommand.
+    str_ref argument;
+    str_ref help;
+    u32     category;
+};
+
+struct term_rec {
+    str_ref term;
+    u32     first_posting;
+    u32     posting_count;
+};
+
+struct posting_rec {
+    u32 entry;
+    u32 weight;
+};
+
+static_assert(std::is_trivially_copyable_v<entry_rec> and sizeof(entry_rec) % sizeof(u32) == 0);
+static_assert(std::is_trivially_copyable_v<term_rec> and sizeof(term_rec) % sizeof(u32) == 0);
+
+/// How much a word counts towards the score of an entry, by where the word was found
+enum field_weight : u32 {
+    /// The name of a subcommand that contains the argument
+    in_path            = 1,
+    in_help            = 1,
+    in_metavar         = 2,
+    in_argument_name   = 6,
+    in_subcommand_name = 8,
+};
+
+/// Call `fn` with each word of the text, in lower case. A word is a run of letters and digits, and
+/// may contain non-ASCII characters.
+template <typename Func>
+void for_each_word(strv text, Func&& fn) {
+    std::string word;
+    auto        flush = [&] {
+        if (not word.empty()) {
+            fn(strv(word));
+            word.clear();
+        }
+    };
+    for (char c : text) {
+        auto uc = static_cast<unsigned char>(c);
+        if (std::isalnum(uc) or uc >= 0x80) {
+            word.push_back(static_cast<char>(std::tolower(uc)));
+        } else {
+            flush();
+        }
+    }
+    flush();
+}
+
+u32 narrow(std::size_t n) {
+    if (n >= ~u32{0}) {
+        throw invalid_argument_params{"Parser tree is too large to be indexed for help search"};
+    }
+    return static_cast<u32>(n);
+}
+
+struct index_writer {
+    std::vector<entry_rec>                                        entries;
+    std::map<std::string, std::vector<posting_rec>, std::less<>> terms;
+    std::string                                                   strings;
+
+    // Identical strings (e.g. options shared by many subcommands) are stored only once
+    std::unordered_map<std::string, str_ref> interned;
+    // The words of the entry being added, with the best weight of each
+    std::map<std::string, u32, std::less<>> entry_words;
+
+    str_ref add_string(strv s) {
+        auto found = interned.find(std::string(s));
+        if (found != interned.end()) {
+            return found->second;
+        }
+        str_ref ref{narrow(strings.size()), narrow(s.size())};
+        strings.append(s);
+        interned.emplace(std::string(s), ref);
+        return ref;
+    }
+
+    void add_words(strv text, field_weight weight) {
+        for_each_word(text, [&](strv word) {
+            auto [it, _] = entry_words.try_emplace(std::string(word), 0);
+            it->second   = (std::max)(it->second, u32{weight});
+        });
+    }
+
+    void finish_entry(strv path, strv argument, std::optional<strv> help, category cat) {
+        auto idx = narrow(entries.size());
+        entries.push_back(entry_rec{
+            .path     = add_string(path),
+            .argument = add_string(argument),
+            .help     = add_string(help.value_or(strv{})),
+            .category = static_cast<u32>(cat),
+        });
+        for (auto& [word, weight] : entry_words) {
+            terms[word].push_back(posting_rec{idx, weight});
+        }
+        entry_words.clear();
+    }
+
+    void
+    add_parser(const detail::argument_parser_impl& impl, const std::string& path, category cat) {
+        for (const argument& arg : impl.all_arguments()) {
+            auto arg_cat = (std::max)(cat, arg.category());
+            if (arg_cat == hidden) {
+                continue;
+            }
+            add_words(path, in_path);
+            for (auto name : arg.names()) {
+                add_words(name, in_argument_name);
+            }
+            if (auto metavar = arg.metavar()) {
+                add_words(*metavar, in_metavar);
+            }
+            if (auto help = arg.help()) {
+                add_words(*help, in_help);
+            }
+            finish_entry(path, arg.preferred_name(), arg.help(), arg_cat);
+        }
+        if (not impl.subparsers) {
+            return;
+        }
+        for (auto& [key, sub] : impl.subparsers->parsers) {
+            auto sub_cat = (std::max)(cat, sub.cat);
+            if (sub_cat == hidden) {
+                continue;
+            }
+            auto  sub_path = path.empty() ? std::string(key) : path + " " + std::string(key);
+            auto& sub_impl = detail::argument_parser_impl::extract(sub.get());
+            auto& desc     = sub_impl.params.description;
+            add_words(path, in_path);
+            add_words(key, in_subcommand_name);
+            if (desc) {
+                add_words(*desc, in_help);
+            }
+            finish_entry(sub_path, "", desc, sub_cat);
+            add_parser(sub_impl, sub_path, sub_cat);
+        }
+    }
+
+    template <typename T>
+    static void append_pod(std::string& out, const T& value) {
+        char buf[sizeof(T)];
+        std::memcpy(buf, &value, sizeof(T));
+        out.append(buf, sizeof(T));
+    }
+
+    std::string finish() {
+        std::vector<term_rec>    term_recs;
+        std::vector<posting_rec> postings;
+        for (auto& [word, list] : terms) {
+            term_recs.push_back(term_rec{
+                .term          = add_string(word),
+                .first_posting = narrow(postings.size()),
+                .posting_count = narrow(list.size()),
+            });
+            postings.insert(postings.end(), list.begin(), list.end());
+        }
+        header hdr{
+            .magic         = index_magic,
+            .version       = index_version,
+            .entry_count   = narrow(entries.size()),
+            .term_count    = narrow(term_recs.size()),
+            .posting_count = narrow(postings.size()),
+            .strings_size  = narrow(strings.size()),
+        };
+        std::string out;
+        append_pod(out, hdr);
+        for (auto& r : entries) {
+            append_pod(out, r);
+        }
+        for (auto& r : term_recs) {
+            append_pod(out, r);
+        }
+        for (auto& r : postings) {
+            append_pod(out, r);
+        }
+        out.append(strings);
+        return out;
+    }
+};
+
+class index_reader {
+    strv        _image;
+    header      _hdr;
+    std::size_t _entries_off  = 0;
+    std::size_t _terms_off    = 0;
+    std::size_t _postings_off = 0;
+    strv        _strings;
+
+    template <typename T>
+    T _read(std::size_t table_offset, u32 index, u32 count) const {
+        if (index >= count) {
+            throw invalid_help_index{"Help index record index is out of bounds"};
+        }
+        T ret;
+        std::memcpy(&ret, _image.data() + table_offset + index * sizeof(T), sizeof(T));
+        return ret;
+    }
+
+    strv _term(u32 index) const {
+        return string(_read<term_rec>(_terms_off, index, _hdr.term_count).term);
+    }
+
+public:
+    explicit index_reader(strv image)
+        : _image(image) {
+        if (image.size() < sizeof(header)) {
+            throw invalid_help_index{"Help index image is truncated"};
+        }
+        std::memcpy(&_hdr, image.data(), sizeof(header));
+        if (_hdr.magic != index_magic or _hdr.version != index_version) {
+            throw invalid_help_index{"Data is not a compatible help index"};
+        }
+        _entries_off  = sizeof(header);
+        _terms_off    = _entries_off + _hdr.entry_count * sizeof(entry_rec);
+        _postings_off = _terms_off + _hdr.term_count * sizeof(term_rec);
+        auto strs_off = _postings_off + _hdr.posting_count * sizeof(posting_rec);
+        if (strs_off + _hdr.strings_size != image.size()) {
+            throw invalid_help_index{"Help index image size does not match its header"};
+        }
+        _strings = image.substr(strs_off);
+    }
+
+    u32 entry_count() const noexcept { return _hdr.entry_count; }
+
+    entry_rec entry(u32 index) const {
+        auto rec = _read<entry_rec>(_entries_off, index, _hdr.entry_count);
+        if (rec.category > static_cast<u32>(hidden)) {
+            throw invalid_help_index{"Help index entry has an invalid category"};
+        }
+        return rec;
+    }
+
+    strv string(str_ref ref) const {
+        if (ref.offset > _strings.size() or ref.size > _strings.size() - ref.offset) {
+            throw invalid_help_index{"Help index string is out of bounds"};
+        }
+        return _strings.substr(ref.offset, ref.size);
+    }
+
+    /// Call `fn` with each posting of each term that starts with the given word, and whether the
+    /// term is the word itself
+    template <typename Func>
+    void for_each_posting(strv word, Func&& fn) const {
+        // Binary search for the first term that is not less than the word
+        u32 first = 0;
+        u32 count = _hdr.term_count;
+        while (count > 0) {
+            auto step = count / 2;
+            if (_term(first + step) < word) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        for (u32 t = first; t < _hdr.term_count; ++t) {
+            auto rec  = _read<term_rec>(_terms_off, t, _hdr.term_count);
+            auto term = string(rec.term);
+            if (not term.starts_with(word)) {
+                break;
+            }
+            for (u32 p = 0; p < rec.posting_count; ++p) {
+                auto post
+                    = _read<posting_rec>(_postings_off, rec.first_posting + p, _hdr.posting_count);
+                fn(post, term.size() == word.size());
+            }
+        }
+    }
+};
+
+}  // namespace
+
+struct debate::detail::help_index_data {
+    /// The tree to build the index from, if it has not been built yet
+    std::optional<argument_parser> parser;
+    std::once_flag                 once;
+    /// The image built from the parser
+    std::string owned;
+    /// The image that is searched: either the owned one or one that was loaded
+    strv                        image;
+    std::optional<index_reader> reader;
+
+    const index_reader& get() {
+        std::call_once(once, [&] {
+            if (parser) {
+                index_writer writer;
+                writer.add_parser(argument_parser_impl::extract(*parser), "", general);
+                owned = writer.finish();
+                image = owned;
+                reader.emplace(image);
+                parser.reset();
+            }
+        });
+        return *reader;
+    }
+};
+
+help_index::help_index(std::unique_ptr<detail::help_index_data> data) noexcept
+    : _data(std::move(data)) {}
+
+help_index::help_index(argument_parser parser)
+    : _data(std::make_unique<detail::help_index_data>()) {
+    _data->parser.emplace(std::move(parser));
+}
+
+help_index::help_index(help_index&&) noexcept            = default;
+help_index& help_index::operator=(help_index&&) noexcept = default;
+help_index::~help_index()                                = default;
+
+help_index help_index::load(strv image) {
+    auto data = std::make_unique<detail::help_index_data>();
+    data->image = image;
+    data->reader.emplace(image);
+    return help_index{std::move(data)};
+}
+
+std::string help_index::save() const {
+    _data->get();
+    return std::string(_data->image);
+}
+
+std::vector<help_search_hit> help_index::search(strv terms, params::for_help_search params) const {
+    auto& reader = _data->get();
+
+    std::vector<std::string> words;
+    for_each_word(terms, [&](strv word) {
+        if (std::ranges::find(words, word) == words.end()) {
+            words.emplace_back(word);
+        }
+    });
+    // The words that were matched by each entry are tracked in a bitmask
+    if (words.size() > 32) {
+        words.resize(32);
+    }
+    if (words.empty()) {
+        return {};
+    }
+
+    struct match {
+        u32      matched = 0;
+        unsigned score   = 0;
+    };
+    std::vector<match>    matches(reader.entry_count());
+    std::vector<unsigned> best(reader.entry_count());
+    std::vector<u32>      touched;
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        // A word that matches several terms of an entry (e.g. as a prefix) counts only once
+        reader.for_each_posting(words[i], [&](posting_rec post, bool exact) {
+            if (post.entry >= best.size()) {
+                throw invalid_help_index{"Help index posting is out of bounds"};
+            }
+            auto score = exact ? post.weight * 2 : post.weight;
+            if (best[post.entry] == 0) {
+                touched.push_back(post.entry);
+            }
+            best[post.entry] = (std::max)(best[post.entry], score);
+        });
+        for (auto entry : touched) {
+            matches[entry].matched |= u32{1} << i;
+            matches[entry].score += best[entry];
+            best[entry] = 0;
+        }
+        touched.clear();
+    }
+
+    auto all_words = words.size() == 32 ? ~u32{0} : (u32{1} << words.size()) - 1;
+    std::vector<help_search_hit> hits;
+    for (u32 e = 0; e < matches.size(); ++e) {
+        if (matches[e].matched != all_words) {
+            continue;
+        }
+        auto rec = reader.entry(e);
+        auto cat = static_cast<category>(rec.category);
+        if (cat > params.max_category) {
+            continue;
+        }
+        hits.push_back(help_search_hit{
+            .subcommand_path = reader.string(rec.path),
+            .argument        = reader.string(rec.argument),
+            .help            = reader.string(rec.help),
+            .category        = cat,
+            .score           = matches[e].score,
+        });
+    }
+    // Hits with equal scores keep the depth-first order of the tree
+    std::ranges::stable_sort(hits, std::ranges::greater{}, &help_search_hit::score);
+    if (hits.size() > params.max_results) {
+        hits.resize(params.max_results);
+    }
+    return hits;
+}
+
+std::string debate::help_search_string(std::span<const help_search_hit> hits) {
+    if (hits.empty()) {
+        return "No arguments or subcommands match the search\n";
+    }
+    std::string ret;
+    for (auto& hit : hits) {
+        ret.append(hit.subcommand_path);
+        if (not hit.subcommand_path.empty() and not hit.argument.empty()) {
+            ret.append(" ");
+        }
+        ret.append(hit.argument);
+        ret.append("\n");
+        if (not hit.help.empty()) {
+            auto help = detail::reflow_text(hit.help, "   ", 79);
+            ret.append(std::string(neo::str_concat(" ➥ ", neo::trim(help), "\n")));
+        }
+    }
+    return ret;
+}
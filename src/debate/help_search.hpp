@@ -0,0 +1,102 @@
+#pragma once
+
+#include "./argument_parser.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace debate {
+
+namespace params {
+
+struct for_help_search {
+    /// Include only the arguments and subcommands up to (and including) this category
+    debate::category max_category = general;
+    /// The maximum number of hits to return
+    std::size_t max_results = 20;
+};
+
+}  // namespace params
+
+/// An argument or subcommand that matched a help search
+struct help_search_hit {
+    /// The subcommands that lead to the hit, separated by spaces. Empty for the top-level parser.
+    std::string_view subcommand_path;
+    /// The preferred name of the argument, or empty if the hit is the subcommand itself
+    std::string_view argument;
+    /// The help text of the argument, or the description of the subcommand
+    std::string_view help;
+    /// The category of the argument or subcommand, or of a subcommand that contains it, whichever
+    /// is the least visible
+    debate::category category;
+    /// The relevance of the hit. Higher is better.
+    unsigned score;
+};
+
+namespace detail {
+
+struct help_index_data;
+
+}  // namespace detail
+
+/**
+ * @brief An inverted index over the help of an entire parser tree, for answering `--help-search`
+ * (see help_search_request) without rendering the help of every subcommand.
+ *
+ * The index maps each word of the argument names, metavars, help text, subcommand names and
+ * subcommand descriptions to the arguments and subcommands that contain it. Hidden arguments and
+ * subcommands are not indexed. An index that is given a parser is built on its first use, so a
+ * program only pays for it when a user actually searches. Building it walks the whole tree,
+ * loading any lazily-loaded subparsers. Alternatively, the image created by save() can be
+ * generated at build time and given to load(), which reads it in place.
+ *
+ * Searching is safe from multiple threads at once.
+ */
+class help_index {
+    std::unique_ptr<detail::help_index_data> _data;
+
+    explicit help_index(std::unique_ptr<detail::help_index_data>) noexcept;
+
+public:
+    /// Create an index of the given parser tree, which will be built when it is first used
+    explicit help_index(argument_parser parser);
+    help_index(help_index&&) noexcept;
+    help_index& operator=(help_index&&) noexcept;
+    ~help_index();
+
+    /**
+     * @brief Use an index image created by save(). The image is not copied, and must outlive the
+     * returned index.
+     *
+     * @throws invalid_help_index if the image is malformed
+     */
+    static help_index load(std::string_view image);
+
+    /**
+     * @brief Serialize the index into a compact binary image. The image uses the native byte
+     * order and is not portable between platforms.
+     */
+    std::string save() const;
+
+    /**
+     * @brief Find the arguments and subcommands that match every word of `terms`.
+     *
+     * Matching is case-insensitive, and a word also matches the longer words that it is a prefix
+     * of. Hits are ranked by where the words were found (in subcommand names first, then argument
+     * names, metavars, and finally help text), with exact matches ahead of prefix matches. The
+     * hits refer to strings held by the index, and remain valid while it exists.
+     *
+     * @throws invalid_help_index if the index was loaded from a malformed image
+     */
+    std::vector<help_search_hit> search(std::string_view          terms,
+                                        params::for_help_search params = {}) const;
+};
+
+/// Render the hits of a help search, in the style of help_string()
+std::string help_search_string(std::span<const help_search_hit> hits);
+
+}  // namespace debate
@@ -0,0 +1,135 @@
+#include "./help_search.hpp"
+
+#include "./error.hpp"
+#include "./snapshot.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using debate::argument_parser;
+
+namespace {
+
+argument_parser build_tree() {
+    argument_parser p{{.prog = "tool"}};
+    p.add_argument({
+        .names       = {"--verbose", "-v"},
+        .action      = debate::null_action,
+        .wants_value = false,
+        .help        = "Print more output",
+    });
+    auto grp    = p.add_subparsers({.action = debate::null_action});
+    auto remote = grp.add_parser({.name = "remote", .description = "Manage remote caches"});
+    auto rsub   = remote.add_subparsers({.action = debate::null_action});
+    auto add    = rsub.add_parser({.name = "add", .description = "Register a new cache"});
+    add.add_argument({
+        .names   = {"--cache-url"},
+        .action  = debate::null_action,
+        .metavar = "<url>",
+        .help    = "Where the cache is served from",
+    });
+    auto build = grp.add_parser({.name = "build", .description = "Build the project"});
+    build.add_argument({
+        .names  = {"--jobs", "-j"},
+        .action = debate::null_action,
+        .help   = "The number of parallel jobs. Uses the cache when possible",
+    });
+    build.add_argument({
+        .names    = {"--trace-cache"},
+        .action   = debate::null_action,
+        .help     = "Log every cache lookup",
+        .category = debate::debugging,
+    });
+    build.add_argument({
+        .names    = {"--secret-cache"},
+        .action   = debate::null_action,
+        .category = debate::hidden,
+    });
+    auto internal = grp.add_parser({.name = "internal", .category = debate::hidden});
+    internal.add_argument({.names = {"--cache-dump"}, .action = debate::null_action});
+    return p;
+}
+
+std::vector<std::string> hit_names(const std::vector<debate::help_search_hit>& hits) {
+    std::vector<std::string> ret;
+    for (auto& hit : hits) {
+        auto name = std::string(hit.subcommand_path);
+        if (not hit.argument.empty()) {
+            name += (name.empty() ? "" : " ") + std::string(hit.argument);
+        }
+        ret.push_back(std::move(name));
+    }
+    return ret;
+}
+
+}  // namespace
+
+TEST_CASE("Search the help of a parser tree") {
+    debate::help_index index{build_tree()};
+
+    // Names outrank help text, exact words outrank prefixes, and hidden arguments and subcommands
+    // are never found
+    auto hits = index.search("cache");
+    CHECK(hit_names(hits)
+          == std::vector<std::string>{
+              "remote add --cache-url",
+              "build --jobs",
+              "remote add",
+              "remote",
+          });
+    CHECK(hits[0].help == "Where the cache is served from");
+    CHECK(hits[3].argument.empty());
+    CHECK(hits[3].help == "Manage remote caches");
+
+    // Less visible categories are only searched when asked for
+    hits = index.search("cache", {.max_category = debate::debugging});
+    CHECK(hit_names(hits).size() == 5);
+    CHECK(hits[0].argument == "--trace-cache");
+    CHECK(hits[0].category == debate::debugging);
+
+    // Every word must match, and a word matches the words that it is a prefix of
+    CHECK(hit_names(index.search("REMOTE url"))
+          == std::vector<std::string>{"remote add --cache-url"});
+    CHECK(hit_names(index.search("parall")) == std::vector<std::string>{"build --jobs"});
+    CHECK(index.search("cache nothing").empty());
+    CHECK(index.search("  ").empty());
+    CHECK(index.search("cache", {.max_results = 1}).size() == 1);
+
+    auto text = debate::help_search_string(index.search("jobs"));
+    CHECK(text.find("build --jobs\n") == 0);
+    CHECK(text.find("The number of parallel jobs") != std::string::npos);
+}
+
+TEST_CASE("Load a prebuilt help index") {
+    auto image = debate::help_index{build_tree()}.save();
+    auto index = debate::help_index::load(image);
+    CHECK(hit_names(index.search("register")) == std::vector<std::string>{"remote add"});
+    CHECK(index.save() == image);
+
+    // A tree loaded from a snapshot has the same index
+    auto snap = debate::save_snapshot(build_tree());
+    CHECK(debate::help_index{debate::load_snapshot(snap)}.save() == image);
+
+    CHECK_THROWS_AS(debate::help_index::load(image.substr(0, 10)), debate::invalid_help_index);
+    CHECK_THROWS_AS(debate::help_index::load("not an index image"), debate::invalid_help_index);
+}
+
+TEST_CASE("--help-search requests a search") {
+    auto parser = build_tree();
+    auto terms  = [&](std::vector<std::string> argv) -> std::string {
+        try {
+            parser.parse_args(argv);
+        } catch (const debate::help_search_request& req) {
+            return req.terms;
+        }
+        return "<none>";
+    };
+    CHECK(terms({"--help-search", "remote", "cache"}) == "remote cache");
+    CHECK(terms({"build", "--help-search=jobs"}) == "jobs");
+    CHECK(terms({"-v", "--help-search"}) == "");
+    CHECK(terms({"build"}) == "<none>");
+    CHECK_THROWS_AS(parser.parse_args(std::vector<std::string>{"--help-searching"}),
+                    debate::unknown_argument);
+}
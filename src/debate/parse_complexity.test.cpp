@@ -0,0 +1,190 @@
+#include <debate/argument_parser.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * These tests feed adversarial command lines to the parser and check that the work per input
+ * byte does not grow with the size of the input. The work is the number of lookups counted by
+ * parse_context::probes(), rather than a time, so that the checks do not depend on the load of the
+ * machine. Each case is parsed at a small and a large size (16x larger), and the large input must
+ * not cost much more per byte than the small one. A quadratic path would show up as a ~16x
+ * increase in per-byte cost.
+ */
+
+namespace {
+
+using debate::argument_parser;
+
+constexpr std::size_t scale_factor = 16;
+// Allows for the constant costs of a parse. Quadratic behavior would exceed this by far.
+constexpr double max_per_byte_growth = 2.0;
+
+std::size_t total_bytes(const std::vector<std::string>& argv) {
+    std::size_t n = 0;
+    for (auto& s : argv) {
+        n += s.size() + 1;
+    }
+    return n;
+}
+
+/// The number of probes made by parsing the given argv, per byte of input
+double probes_per_byte(const argument_parser& p, const std::vector<std::string>& argv) {
+    debate::parse_context ctx;
+    p.parse_args(argv, {.context = &ctx});
+    return static_cast<double>(ctx.probes()) / static_cast<double>(total_bytes(argv));
+}
+
+void check_linear(const argument_parser&          small_parser,
+                  const std::vector<std::string>& small_argv,
+                  const argument_parser&          large_parser,
+                  const std::vector<std::string>& large_argv) {
+    auto small_per_byte = probes_per_byte(small_parser, small_argv);
+    auto large_per_byte = probes_per_byte(large_parser, large_argv);
+    INFO("Small input: " << small_per_byte << " probes/byte");
+    INFO("Large input: " << large_per_byte << " probes/byte");
+    CHECK(small_per_byte > 0);
+    CHECK(large_per_byte < small_per_byte * max_per_byte_growth);
+}
+
+void check_linear(const argument_parser& p, auto make_argv, std::size_t base_size) {
+    check_linear(p, make_argv(base_size), p, make_argv(base_size * scale_factor));
+}
+
+}  // namespace
+
+TEST_CASE("Huge short-flag cluster") {
+    argument_parser p;
+    p.add_argument({
+        .names       = {"--ex", "-x"},
+        .action      = debate::null_action,
+        .can_repeat  = true,
+        .wants_value = false,
+    });
+    for (char c = 'a'; c < 'x'; ++c) {
+        p.add_argument({
+            .names       = {std::string("-") + c},
+            .action      = debate::null_action,
+            .wants_value = false,
+        });
+    }
+    check_linear(
+        p,
+        [](std::size_t n) { return std::vector<std::string>{"-" + std::string(n, 'x')}; },
+        4096);
+}
+
+TEST_CASE("Long values given with an equal sign") {
+    argument_parser p;
+    std::size_t     total = 0;
+    p.add_argument({
+        .names      = {"--value"},
+        .action     = [&](auto, auto val) { total += val.size(); },
+        .can_repeat = true,
+    });
+    check_linear(
+        p,
+        [](std::size_t n) {
+            return std::vector<std::string>(8, "--value=" + std::string(n, 'v'));
+        },
+        4096);
+    CHECK(total != 0);
+}
+
+TEST_CASE("Many positional words") {
+    argument_parser p;
+    for (int i = 0; i < 32; ++i) {
+        p.add_argument({
+            .names    = {"--opt-" + std::to_string(i)},
+            .action   = debate::null_action,
+            .required = false,
+        });
+    }
+    p.add_argument({.names = {"first"}, .action = debate::null_action});
+    p.add_argument({.names = {"second"}, .action = debate::null_action});
+    std::size_t count = 0;
+    p.add_argument({
+        .names      = {"rest"},
+        .action     = [&](auto, auto) { ++count; },
+        .can_repeat = true,
+    });
+    check_linear(
+        p,
+        [](std::size_t n) { return std::vector<std::string>(n, "some/path/name"); },
+        2048);
+    CHECK(count != 0);
+}
+
+TEST_CASE("Many leading positionals") {
+    // Every word after the leading positionals goes to the repeatable one at the end, which must
+    // not require scanning the positionals that were already satisfied.
+    auto make_parser = [](std::size_t n_leading) {
+        argument_parser p;
+        for (std::size_t i = 0; i < n_leading; ++i) {
+            p.add_argument({.names = {"pos-" + std::to_string(i)}, .action = debate::null_action});
+        }
+        p.add_argument({
+            .names      = {"rest"},
+            .action     = debate::null_action,
+            .can_repeat = true,
+        });
+        return p;
+    };
+    auto make_argv = [](std::size_t n_leading) {
+        return std::vector<std::string>(n_leading * 16, "some/path/name");
+    };
+    constexpr std::size_t base = 128;
+
+    auto small = make_parser(base);
+    auto large = make_parser(base * scale_factor);
+    check_linear(small, make_argv(base), large, make_argv(base * scale_factor));
+}
+
+TEST_CASE("Deep subparser nesting") {
+    auto make_nested = [](std::size_t depth) {
+        argument_parser root;
+        root.add_argument({
+            .names  = {"--root-opt"},
+            .action = debate::null_action,
+        });
+        auto tail = root;
+        for (std::size_t i = 0; i < depth; ++i) {
+            tail = tail.add_subparsers({.action = debate::null_action, .required = false})
+                       .add_parser({.name = "sub"});
+        }
+        return root;
+    };
+    auto make_argv = [](std::size_t depth) {
+        std::vector<std::string> argv(depth, "sub");
+        argv.push_back("--root-opt=value");
+        return argv;
+    };
+    constexpr std::size_t base = 128;
+
+    auto small = make_nested(base);
+    auto large = make_nested(base * scale_factor);
+    check_linear(small, make_argv(base), large, make_argv(base * scale_factor));
+}
+
+TEST_CASE("Help search words after an error") {
+    // The unknown argument makes the parser look for a help request among all the words, which
+    // must not gather the search terms again for each `--help-search`. Gathering a word counts as
+    // a probe.
+    argument_parser p;
+    p.add_argument({.names = {"--value"}, .action = debate::null_action});
+    auto probes_per_byte = [&](std::size_t n) {
+        std::vector<std::string> argv(n, "--help-search=");
+        argv.insert(argv.begin(), "--bogus");
+        debate::parse_context ctx;
+        CHECK_THROWS_AS(p.parse_args(argv, {.context = &ctx}), debate::help_search_request);
+        return static_cast<double>(ctx.probes()) / static_cast<double>(total_bytes(argv));
+    };
+    auto small_per_byte = probes_per_byte(256);
+    auto large_per_byte = probes_per_byte(256 * scale_factor);
+    INFO("Small input: " << small_per_byte << " probes/byte");
+    INFO("Large input: " << large_per_byte << " probes/byte");
+    CHECK(small_per_byte > 0);
+    CHECK(large_per_byte < small_per_byte * max_per_byte_growth);
+}
@@ -0,0 +1,389 @@
+#include <debate/argument_parser.hpp>
+#include <debate/cmdline.hpp>
+#include <debate/config_file.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * These tests replace the global allocation functions with ones that count the number of
+ * allocations, and check that reusing a parse_context makes parsing allocation-free.
+ */
+
+namespace {
+
+std::atomic<bool>        counting{false};
+std::atomic<std::size_t> n_allocations{0};
+
+/// Count the allocations made while running the given function
+template <typename Func>
+std::size_t count_allocations(Func&& fn) {
+    n_allocations = 0;
+    counting      = true;
+    fn();
+    counting = false;
+    return n_allocations;
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    if (counting) {
+        ++n_allocations;
+    }
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+// GCC warns when one of these is inlined into a caller that got its pointer from operator new,
+// not knowing that the operator new above allocates with malloc
+#if defined(__GNUC__) and __GNUC__ >= 11 and not defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// The default memory resource allocates with the aligned forms
+void* operator new(std::size_t size, std::align_val_t align) {
+    if (counting) {
+        ++n_allocations;
+    }
+    auto alignment = static_cast<std::size_t>(align);
+    auto rounded   = (size + alignment - 1) / alignment * alignment;
+    if (void* ptr = std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+TEST_CASE("Reused parse_context does not allocate") {
+    debate::argument_parser parser;
+    std::string             output;
+    std::string             input;
+    bool                    verbose = false;
+    parser.add_argument({
+        .names  = {"--output-filename", "-o"},
+        .action = debate::store_string(output),
+    });
+    parser.add_argument({
+        .names       = {"--verbose", "-v"},
+        .action      = debate::store_true(verbose),
+        .wants_value = false,
+    });
+    parser.add_argument({
+        .names  = {"input"},
+        .action = debate::store_string(input),
+    });
+    auto sub = parser.add_subparsers({.action = debate::null_action});
+    auto build = sub.add_parser({.name = "build"});
+    build.add_argument({
+        .names      = {"--jobs", "-j"},
+        .action     = debate::null_action,
+        .can_repeat = true,
+    });
+
+    const std::vector<std::string> argv = {
+        "--output-filename=/some/long/path/to/an/output/file.txt",
+        "-v",
+        "a/long/enough/input/file/name.cpp",
+        "build",
+        "-j8",
+        "--jobs",
+        "16",
+    };
+    debate::parse_context ctx;
+    // Warm up the context and the storage targets
+    parser.parse_args(argv, {.context = &ctx});
+    CHECK(output == "/some/long/path/to/an/output/file.txt");
+    CHECK(input == "a/long/enough/input/file/name.cpp");
+    CHECK(verbose);
+
+    auto n = count_allocations([&] {
+        for (int i = 0; i < 100; ++i) {
+            parser.parse_args(argv, {.context = &ctx});
+        }
+    });
+    CHECK(n == 0);
+    CHECK(output == "/some/long/path/to/an/output/file.txt");
+
+    // Without a context, each parse needs its own storage
+    n = count_allocations([&] { parser.parse_args(argv); });
+    CHECK(n != 0);
+}
+
+TEST_CASE("parse_context can be reused after an error") {
+    debate::argument_parser parser;
+    parser.add_argument({.names = {"--name"}, .action = debate::null_action});
+
+    debate::parse_context ctx;
+    std::vector<std::string> bad = {"--name"};
+    CHECK_THROWS(parser.parse_args(bad, {.context = &ctx}));
+
+    std::vector<std::string> good = {"--name", "value"};
+    parser.parse_args(good, {.context = &ctx});
+    auto n = count_allocations([&] { parser.parse_args(good, {.context = &ctx}); });
+    CHECK(n == 0);
+}
+
+TEST_CASE("Incremental parsing resumes after the unchanged words") {
+    debate::argument_parser  parser;
+    int                      n_verbose = 0;
+    std::vector<std::string> files;
+    parser.add_argument({
+        .names       = {"--verbose", "-v"},
+        .action      = [&](auto, auto) { ++n_verbose; },
+        .wants_value = false,
+    });
+    auto sub   = parser.add_subparsers({.action = debate::null_action});
+    auto build = sub.add_parser({.name = "build"});
+    build.add_argument({
+        .names    = {"--jobs", "-j"},
+        .action   = debate::null_action,
+        .validate = [](auto, std::string_view value) {
+            if (value.find_first_not_of("0123456789") != value.npos) {
+                throw debate::invalid_argument_value{"Not a number"};
+            }
+        },
+        .required = true,
+    });
+    build.add_argument({
+        .names  = {"--files"},
+        .action = [&](auto, std::string_view value) { files.emplace_back(value); },
+        .nargs  = '+',
+    });
+
+    debate::parse_context ctx;
+    auto parse = [&](std::vector<std::string> argv) {
+        files.clear();
+        parser.parse_args(argv, {.context = &ctx, .incremental = true});
+    };
+    parse({"-v", "build", "-j", "4", "--files", "a", "b"});
+    CHECK(ctx.resumed_at() == 0);
+    CHECK(n_verbose == 1);
+    CHECK(files == std::vector<std::string>{"a", "b"});
+
+    // "--files" consumed every word up to the end, so another file restarts it
+    parse({"-v", "build", "-j", "4", "--files", "a", "b", "c"});
+    CHECK(ctx.resumed_at() == 4);
+    CHECK(n_verbose == 1);
+    CHECK(files == std::vector<std::string>{"a", "b", "c"});
+
+    // Editing a word only re-parses from the last step before it
+    CHECK_THROWS_AS(parse({"-v", "build", "-j", "four", "--files", "a"}),
+                    debate::invalid_argument_value);
+    CHECK(ctx.resumed_at() == 2);
+    CHECK(n_verbose == 1);
+
+    // The final checks still see the state of the skipped words
+    CHECK_THROWS_AS(parse({"-v", "build"}), debate::missing_argument);
+    CHECK(ctx.resumed_at() == 2);
+    parse({"-v", "build", "--jobs=2"});
+    CHECK(ctx.resumed_at() == 2);
+    CHECK_THROWS_AS(parse({"-v", "build", "--jobs=2", "--jobs=3"}),
+                    debate::invalid_argument_repetition);
+    CHECK(ctx.resumed_at() == 3);
+
+    // Changing the first word, or forgetting the checkpoints, parses everything again
+    parse({"build", "-j", "1"});
+    CHECK(ctx.resumed_at() == 0);
+    CHECK(n_verbose == 1);
+    ctx.clear_checkpoints();
+    parse({"build", "-j", "1"});
+    CHECK(ctx.resumed_at() == 0);
+
+    // An identical command line resumes at its end
+    parse({"build", "-j", "1"});
+    CHECK(ctx.resumed_at() == 3);
+
+    // A parse that is not incremental always starts from the beginning
+    parser.parse_args(std::vector<std::string>{"build", "-j", "1"}, {.context = &ctx});
+    CHECK(ctx.resumed_at() == 0);
+}
+
+TEST_CASE("Incremental parsing keeps the subcommands before the checkpoint") {
+    debate::argument_parser    parser;
+    std::optional<std::string> input;
+    auto sub   = parser.add_subparsers({.action = debate::null_action});
+    auto build = sub.add_parser({.name = "build"});
+    build.add_argument({.names = {"--jobs", "-j"}, .action = debate::null_action});
+    build.add_argument({.names = {"--input"}, .action = debate::store_string(input)});
+
+    auto cfg = debate::config_file::from_string(R"(
+        [build]
+        input = from-config.txt
+    )");
+    debate::parse_context ctx;
+    debate::parse_summary summary;
+    auto parse = [&](std::vector<std::string> argv) {
+        input.reset();
+        parser.parse_args(argv,
+                          {.config      = &cfg,
+                           .context     = &ctx,
+                           .incremental = true,
+                           .summary     = &summary});
+    };
+    parse({"build", "-j", "4"});
+    // The parse resumes inside "build", whose config section still applies
+    parse({"build", "-j", "8"});
+    REQUIRE(ctx.resumed_at() == 1);
+    CHECK(summary.subcommand_path == std::vector<std::string_view>{"build"});
+    CHECK(input == "from-config.txt");
+}
+
+TEST_CASE("Checking command lines from a reused cmdline_buffer does not allocate") {
+    debate::argument_parser parser;
+    parser.add_argument({
+        .names   = {"--mode", "-m"},
+        .action  = debate::null_action,
+        .choices = debate::choice_set{"fast", "slow"},
+    });
+    parser.add_argument({
+        .names      = {"inputs"},
+        .action     = debate::null_action,
+        .can_repeat = true,
+    });
+
+    using namespace std::literals;
+    std::vector<std::string_view> cmdlines = {
+        "tool\0--mode=fast\0some/long/input/file/name.txt\0another/input/file.txt\0"sv,
+        "tool\0-m\0slow\0x\0"sv,
+    };
+    debate::cmdline_buffer buf;
+    debate::parse_context  ctx;
+    auto check_all = [&] {
+        for (auto cmdline : cmdlines) {
+            buf.assign(cmdline);
+            parser.parse_args(buf.args(), {.context = &ctx, .run_actions = false});
+        }
+    };
+    // Warm up the buffer and the context
+    check_all();
+    CHECK(count_allocations([&] {
+              for (int i = 0; i < 100; ++i) {
+                  check_all();
+              }
+          })
+          == 0);
+}
+
+TEST_CASE("Parse from a caller-provided memory resource") {
+    std::array<std::byte, 1 << 16>      buffer;
+    std::pmr::monotonic_buffer_resource arena{buffer.data(),
+                                              buffer.size(),
+                                              std::pmr::null_memory_resource()};
+
+    // The names, help text and lookup tables of the whole tree are kept in the arena
+    debate::argument_parser parser{{.memory = &arena}};
+    parser.add_argument({
+        .names  = {"--output-filename", "-o"},
+        .action = debate::null_action,
+        .help   = "The file to write to, which has a long enough description to need storage",
+    });
+    auto sub   = parser.add_subparsers({.action = debate::null_action});
+    auto build = sub.add_parser({.name = "build"});
+    build.add_argument({.names = {"--jobs", "-j"}, .action = debate::null_action});
+
+    const std::vector<std::string> argv = {
+        "--output-filename=/some/long/path/to/an/output/file.txt",
+        "build",
+        "--jobs",
+        "16",
+    };
+    // Without a context, the working storage of the parse comes from the arena
+    CHECK(count_allocations([&] { parser.parse_args(argv, {.memory = &arena}); }) == 0);
+    // Words are viewed in place, so the one allocation is the temporary vector of words
+    CHECK(count_allocations([&] {
+              parser.parse_args(std::vector<std::string_view>{"build", "-j8"},
+                                {.memory = &arena});
+          })
+          == 1);
+
+    // A context takes its storage from its own resource
+    debate::parse_context ctx{&arena};
+    CHECK(count_allocations([&] { parser.parse_args(argv, {.context = &ctx}); }) == 0);
+}
+
+TEST_CASE("Argument groups keep their strings in the given memory resource") {
+    struct counting_resource : std::pmr::memory_resource {
+        std::size_t n_allocations = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t align) override {
+            ++n_allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void* ptr, std::size_t bytes, std::size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(ptr, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    } resource;
+
+    // The group itself is allocated from the resource
+    debate::argument_group common{&resource};
+    auto                   n_created = resource.n_allocations;
+    CHECK(n_created != 0);
+    common.add_argument({
+        .names  = {"--color"},
+        .action = debate::null_action,
+        .help   = "Whether to colorize the output, which has a long enough description",
+    });
+    CHECK(resource.n_allocations > n_created);
+}
+
+TEST_CASE("Parser trees do not fall back to the default memory resource") {
+    struct failing_resource : std::pmr::memory_resource {
+        void* do_allocate(std::size_t, std::size_t) override { throw std::bad_alloc{}; }
+        void  do_deallocate(void*, std::size_t, std::size_t) override {}
+        bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    } failing;
+    // Restore the default resource even if the test fails
+    struct default_resource_guard {
+        std::pmr::memory_resource* prev;
+        ~default_resource_guard() { std::pmr::set_default_resource(prev); }
+    };
+
+    std::array<std::byte, 1 << 16>      buffer;
+    std::pmr::monotonic_buffer_resource arena{buffer.data(),
+                                              buffer.size(),
+                                              std::pmr::null_memory_resource()};
+    default_resource_guard              guard{std::pmr::set_default_resource(&failing)};
+
+    debate::argument_parser parser{{.memory = &arena}};
+    auto quiet   = parser.add_argument({.names = {"--quiet", "-q"}, .action = debate::null_action});
+    auto verbose = parser.add_argument({.names = {"--verbose"}, .action = debate::null_action});
+    parser.add_constraint({
+        .kind      = debate::constraint_kind::at_most_one,
+        .arguments = {quiet, verbose},
+    });
+    debate::argument_group common{&arena};
+    common.add_argument({.names = {"--color"}, .action = debate::null_action});
+    parser.add_group(common);
+    auto sub = parser.add_subparsers({.action = debate::null_action});
+    for (std::string name : {"build", "test", "a-subcommand-with-a-long-name"}) {
+        auto child = sub.add_parser({.name = name});
+        child.add_argument({.names = {"--jobs", "-j"}, .action = debate::null_action});
+        child.add_argument({.names = {"target"}, .action = debate::null_action});
+        child.add_group(common);
+    }
+
+    const std::vector<std::string> argv = {"-q", "--color=red", "test", "-j4", "all"};
+    CHECK_NOTHROW(parser.parse_args(argv, {.memory = &arena}));
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "./argument.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string_view>
+
+namespace debate {
+
+/**
+ * @brief The kind of a parse_event
+ *
+ * The enumerator values are stable and fit in a single byte, so that they may be written directly
+ * into a compact binary trace.
+ */
+enum class parse_event_kind : std::uint8_t {
+    /// A new word from the argv array is about to be parsed
+    word_lexed = 0,
+    /// An argument was matched by the given spelling
+    argument_matched = 1,
+    /// A value is being bound to a matched argument (the argument's action is about to run)
+    value_bound = 2,
+    /// A subparser was selected and appended to the parser chain
+    subparser_entered = 3,
+    /// A required argument is being checked after all words have been parsed
+    finalize_check = 4,
+    /// An exception is escaping the parse
+    error_raised = 5,
+    /// A word was not consumed, and was put in the remainder (see params::for_parse::remainder)
+    word_skipped = 6,
+};
+
+/**
+ * @brief A single structured event emitted during parsing.
+ *
+ * All string views refer into the argv array being parsed or into the parser definition, and are
+ * only valid for the duration of the parse_observer::on_event() call.
+ */
+struct parse_event {
+    parse_event_kind kind;
+
+    /// The index of the argv word that was being parsed, or -1 during finalization
+    std::ptrdiff_t word_index = -1;
+    /// The argv word that was being parsed
+    std::string_view word{};
+    /// The name by which the argument (or subparser) was selected
+    std::string_view spelling{};
+    /// The value that was bound to the argument
+    std::string_view value{};
+
+    /// The depth of the parser that owns the argument. Zero is the top-level parser.
+    std::size_t parser_depth = 0;
+    /// The argument that was matched, bound, or checked (if applicable)
+    const debate::argument* arg = nullptr;
+    /// The ordinal of `arg` within its parser, in the order it was added with add_argument()
+    std::size_t argument_index = 0;
+
+    /// The exception that is being raised (only for error_raised)
+    const std::exception* error = nullptr;
+};
+
+/**
+ * @brief Interface for receiving parse_events from argument_parser::parse_args()
+ *
+ * Attach an observer using params::for_parse::observer. If no observer is attached, no events are
+ * constructed.
+ */
+class parse_observer {
+public:
+    virtual void on_event(const parse_event& ev) = 0;
+
+protected:
+    ~parse_observer() = default;
+};
+
+}  // namespace debate
@@ -0,0 +1,348 @@
+#include "./schema.hpp"
+
+#include "./detail/parser_impl.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+
+using namespace debate;
+using strv = std::string_view;
+
+namespace {
+
+strv category_name(category cat) noexcept {
+    switch (cat) {
+    case general:
+        return "general";
+    case advanced:
+        return "advanced";
+    case debugging:
+        return "debugging";
+    case hidden:
+        return "hidden";
+    }
+    return "general";
+}
+
+strv constraint_name(constraint_kind kind) noexcept {
+    switch (kind) {
+    case constraint_kind::at_most_one:
+        return "at_most_one";
+    case constraint_kind::exactly_one:
+        return "exactly_one";
+    case constraint_kind::at_least_one:
+        return "at_least_one";
+    case constraint_kind::dependency:
+        return "dependency";
+    }
+    return "";
+}
+
+class schema_writer {
+    std::function<void(strv)>& _sink;
+    params::for_schema_export  _params;
+    std::array<char, 4096>     _buf;
+    std::size_t                _used = 0;
+
+    void _flush() {
+        if (_used != 0) {
+            _sink(strv(_buf.data(), _used));
+            _used = 0;
+        }
+    }
+
+    void _put(char c) {
+        if (_used == _buf.size()) {
+            _flush();
+        }
+        _buf[_used++] = c;
+    }
+
+    void _put(strv s) {
+        while (not s.empty()) {
+            if (_used == _buf.size()) {
+                _flush();
+            }
+            auto n = (std::min)(s.size(), _buf.size() - _used);
+            std::memcpy(_buf.data() + _used, s.data(), n);
+            _used += n;
+            s.remove_prefix(n);
+        }
+    }
+
+    static bool _needs_escape(char c) noexcept {
+        return c == '"' or c == '\\' or static_cast<unsigned char>(c) < 0x20;
+    }
+
+    void _put_string(strv s) {
+        _put('"');
+        while (not s.empty()) {
+            // Copy the run of characters that need no escaping in one go
+            auto plain = s.size();
+            if (auto it = std::ranges::find_if(s, _needs_escape); it != s.end()) {
+                plain = static_cast<std::size_t>(it - s.begin());
+            }
+            _put(s.substr(0, plain));
+            s.remove_prefix(plain);
+            if (s.empty()) {
+                break;
+            }
+            char c = s.front();
+            s.remove_prefix(1);
+            switch (c) {
+            case '"':
+                _put("\\\"");
+                break;
+            case '\\':
+                _put("\\\\");
+                break;
+            case '\n':
+                _put("\\n");
+                break;
+            case '\r':
+                _put("\\r");
+                break;
+            case '\t':
+                _put("\\t");
+                break;
+            default: {
+                // Any other control character
+                constexpr strv hex = "0123456789abcdef";
+                auto           u   = static_cast<unsigned char>(c);
+                _put("\\u00");
+                _put(hex[u >> 4]);
+                _put(hex[u & 0xf]);
+            }
+            }
+        }
+        _put('"');
+    }
+
+    void _put_opt_string(std::optional<strv> s) {
+        if (s) {
+            _put_string(*s);
+        } else {
+            _put("null");
+        }
+    }
+
+    void _put_help(std::optional<strv> s) {
+        if (_params.include_help) {
+            _put_opt_string(s);
+        } else {
+            _put("null");
+        }
+    }
+
+    void _put_bool(bool b) { _put(b ? "true" : "false"); }
+
+    void _put_number(std::size_t n) {
+        std::array<char, 24> digits;
+        auto res = std::to_chars(digits.data(), digits.data() + digits.size(), n);
+        _put(strv(digits.data(), static_cast<std::size_t>(res.ptr - digits.data())));
+    }
+
+    void _put_key(strv key) {
+        _put_string(key);
+        _put(':');
+    }
+
+    void _put_argument(const argument& arg) {
+        _put("{");
+        _put_key("names");
+        _put('[');
+        for (auto& name : arg.names()) {
+            if (&name != &arg.names().front()) {
+                _put(',');
+            }
+            _put_string(name);
+        }
+        _put("],");
+        _put_key("positional");
+        _put_bool(arg.is_positional());
+        _put(',');
+        _put_key("metavar");
+        _put_opt_string(arg.metavar());
+        _put(',');
+        _put_key("help");
+        _put_help(arg.help());
+        _put(',');
+        _put_key("category");
+        _put_string(category_name(arg.category()));
+        _put(',');
+        _put_key("required");
+        _put_bool(arg.is_required());
+        _put(',');
+        _put_key("can_repeat");
+        _put_bool(arg.can_repeat());
+        _put(',');
+        _put_key("wants_value");
+        _put_bool(arg.wants_value());
+        _put(',');
+        _put_key("choices");
+        if (arg.choices()) {
+            _put('[');
+            for (auto& word : arg.choices()->words()) {
+                if (&word != &arg.choices()->words().front()) {
+                    _put(',');
+                }
+                _put_string(word);
+            }
+            _put(']');
+        } else {
+            _put("null");
+        }
+        _put(',');
+        _put_key("nargs");
+        if (auto count = arg.nargs()) {
+            _put('{');
+            _put_key("min");
+            _put_number(count->min);
+            _put(',');
+            _put_key("max");
+            if (count->max == value_count::unlimited) {
+                _put("null");
+            } else {
+                _put_number(count->max);
+            }
+            _put('}');
+        } else {
+            _put("null");
+        }
+        _put(',');
+        _put_key("delimiter");
+        if (auto delim = arg.delimiter()) {
+            _put_string(strv(&*delim, 1));
+        } else {
+            _put("null");
+        }
+        _put(',');
+        _put_key("default");
+        if (auto dflt = arg.default_value() ? arg.default_value()->literal() : std::nullopt) {
+            _put_string(*dflt);
+        } else {
+            _put("null");
+        }
+        _put('}');
+    }
+
+    /// Write the members of a parser object (without the enclosing braces)
+    void _put_parser_members(const detail::argument_parser_impl& impl) {
+        _put_key("prog");
+        _put_opt_string(impl.params.prog);
+        _put(',');
+        _put_key("description");
+        _put_help(impl.params.description);
+        _put(',');
+        _put_key("epilog");
+        _put_help(impl.params.epilog);
+        _put(',');
+
+        _put_key("arguments");
+        _put('[');
+        bool first = true;
+        for (const argument& arg : impl.all_arguments()) {
+            if (arg.category() > _params.max_category) {
+                continue;
+            }
+            if (not first) {
+                _put(',');
+            }
+            first = false;
+            _put_argument(arg);
+        }
+        _put("],");
+
+        _put_key("constraints");
+        _put('[');
+        for (auto& con : impl.constraints) {
+            if (&con != &impl.constraints.front()) {
+                _put(',');
+            }
+            _put('{');
+            _put_key("kind");
+            _put_string(constraint_name(con.def.kind));
+            _put(',');
+            _put_key("arguments");
+            _put('[');
+            for (std::size_t idx = 0; idx < con.ordinals.size(); ++idx) {
+                if (idx != 0) {
+                    _put(',');
+                }
+                _put_number(con.ordinals[idx]);
+            }
+            _put("]}");
+        }
+        _put("],");
+
+        _put_key("subcommands");
+        if (not impl.subparsers) {
+            _put("null");
+            return;
+        }
+        auto& grp = *impl.subparsers;
+        _put('{');
+        _put_key("title");
+        _put_string(grp.title);
+        _put(',');
+        _put_key("description");
+        _put_help(grp.description);
+        _put(',');
+        _put_key("required");
+        _put_bool(grp.required);
+        _put(',');
+        _put_key("parsers");
+        _put('[');
+        first = true;
+        for (auto& [name, sub] : grp.parsers) {
+            if (sub.cat > _params.max_category) {
+                continue;
+            }
+            if (not first) {
+                _put(',');
+            }
+            first = false;
+            _put('{');
+            _put_key("name");
+            _put_string(name);
+            _put(',');
+            _put_key("category");
+            _put_string(category_name(sub.cat));
+            _put(',');
+            _put_parser_members(detail::argument_parser_impl::extract(sub.get()));
+            _put('}');
+        }
+        _put("]}");
+    }
+
+public:
+    schema_writer(std::function<void(strv)>& sink, params::for_schema_export params)
+        : _sink(sink)
+        , _params(params) {}
+
+    void write(const argument_parser& parser) {
+        _put('{');
+        _put_parser_members(detail::argument_parser_impl::extract(parser));
+        _put('}');
+        _flush();
+    }
+};
+
+}  // namespace
+
+void debate::export_schema(const argument_parser&    parser,
+                           std::function<void(strv)> sink,
+                           params::for_schema_export params) {
+    schema_writer{sink, params}.write(parser);
+}
+
+std::string debate::schema_json(const argument_parser& parser, params::for_schema_export params) {
+    std::string ret;
+    export_schema(
+        parser,
+        [&](strv chunk) { ret.append(chunk); },
+        params);
+    return ret;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "./argument_parser.hpp"
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace debate {
+
+namespace params {
+
+struct for_schema_export {
+    /// Include only the arguments and subcommands up to (and including) this category
+    debate::category max_category = debugging;
+    /// Include the help text, descriptions, and epilogs
+    bool include_help = true;
+};
+
+}  // namespace params
+
+/**
+ * @brief Write a JSON description of an entire parser tree to a sink.
+ *
+ * The tree is walked once, depth-first. Output is collected in a fixed-size buffer and handed to
+ * the sink in chunks, so memory use does not depend on the size of the tree (aside from the
+ * stack, which grows with the nesting depth of subcommands). The chunks are only valid for the
+ * duration of each call to the sink. Lazily-loaded subparsers are loaded as they are visited.
+ *
+ * The document has this shape:
+ *
+ *      {"prog": ..., "description": ..., "epilog": ...,
+ *       "arguments": [{"names": [...], "positional": bool, "metavar": ..., "help": ...,
+ *                      "category": "general", "required": bool, "can_repeat": bool,
+ *                      "wants_value": bool, "choices": [...]}, ...],
+ *       "constraints": [{"kind": "at_most_one", "arguments": [<index>, ...]}, ...],
+ *       "subcommands": {"title": ..., "description": ..., "required": bool,
+ *                       "parsers": [{"name": ..., "category": ..., <the same as above>}]}}
+ *
+ * Optional strings that are not set are written as null, and "subcommands" is null for a parser
+ * without subcommands. Constraint arguments are indices into the parser's unfiltered argument
+ * list, in the order they were added.
+ */
+void export_schema(const argument_parser&               parser,
+                   std::function<void(std::string_view)> sink,
+                   params::for_schema_export             params = {});
+
+/// Export the schema of a parser tree into a single string
+std::string schema_json(const argument_parser& parser, params::for_schema_export params = {});
+
+}  // namespace debate
@@ -0,0 +1,84 @@
+#include "./schema.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <string>
+
+using debate::argument_parser;
+
+TEST_CASE("Export a parser schema") {
+    argument_parser p{{.prog = "tool", .description = "Does \"things\"\n"}};
+    auto            json = p.add_argument({
+        .names       = {"--json", "-j"},
+        .action      = debate::null_action,
+        .wants_value = false,
+        .help        = "Print JSON",
+    });
+    auto yaml = p.add_argument({
+        .names       = {"--yaml"},
+        .action      = debate::null_action,
+        .wants_value = false,
+        .category    = debate::advanced,
+    });
+    p.add_argument({
+        .names    = {"--secret"},
+        .action   = debate::null_action,
+        .category = debate::hidden,
+    });
+    p.add_constraint({.kind = debate::constraint_kind::at_most_one, .arguments = {json, yaml}});
+    auto grp = p.add_subparsers({.action = debate::null_action});
+    grp.add_parser({.name = "run"}).add_argument({
+        .names   = {"mode"},
+        .action  = debate::null_action,
+        .choices = debate::choice_set{"fast", "slow"},
+        .nargs   = '+',
+    });
+
+    CHECK(debate::schema_json(p)
+          == R"({"prog":"tool","description":"Does \"things\"\n","epilog":null,)"
+             R"("arguments":[)"
+             R"({"names":["--json","-j"],"positional":false,"metavar":null,"help":"Print JSON",)"
+             R"("category":"general","required":false,"can_repeat":false,"wants_value":false,)"
+             R"("choices":null,"nargs":null,"delimiter":null,"default":null},)"
+             R"({"names":["--yaml"],"positional":false,"metavar":null,"help":null,)"
+             R"("category":"advanced","required":false,"can_repeat":false,"wants_value":false,)"
+             R"("choices":null,"nargs":null,"delimiter":null,"default":null}],)"
+             R"("constraints":[{"kind":"at_most_one","arguments":[0,1]}],)"
+             R"("subcommands":{"title":"subcommands","description":null,"required":true,)"
+             R"("parsers":[{"name":"run","category":"general","prog":"run","description":null,)"
+             R"("epilog":null,"arguments":[{"names":["mode"],"positional":true,"metavar":null,)"
+             R"("help":null,"category":"general","required":true,"can_repeat":false,)"
+             R"("wants_value":true,"choices":["fast","slow"],"nargs":{"min":1,"max":null},)"
+             R"("delimiter":null,"default":null}],"constraints":[],)"
+             R"("subcommands":null}]}})");
+
+    auto general_only = debate::schema_json(p, {.max_category = debate::general});
+    CHECK(general_only.find("--yaml") == std::string::npos);
+    auto no_help = debate::schema_json(p, {.include_help = false});
+    CHECK(no_help.find("Print JSON") == std::string::npos);
+}
+
+TEST_CASE("Export a large schema in bounded chunks") {
+    argument_parser p;
+    auto            grp = p.add_subparsers({.action = debate::null_action});
+    for (int i = 0; i < 2000; ++i) {
+        auto sub = grp.add_parser({.name = "command-" + std::to_string(i)});
+        for (int j = 0; j < 4; ++j) {
+            sub.add_argument({
+                .names  = {"--option-" + std::to_string(j)},
+                .action = debate::null_action,
+                .help   = "Some help text for this option",
+            });
+        }
+    }
+    std::size_t max_chunk = 0;
+    std::size_t total     = 0;
+    debate::export_schema(p, [&](std::string_view chunk) {
+        max_chunk = (std::max)(max_chunk, chunk.size());
+        total += chunk.size();
+    });
+    CHECK(max_chunk <= 4096);
+    CHECK(total == debate::schema_json(p).size());
+    CHECK(total > 1'000'000);
+}
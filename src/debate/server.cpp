@@ -0,0 +1,529 @@
+#include "./server.hpp"
+
+#include "./error.hpp"
+#include "./help_search.hpp"
+
+#include <boost/leaf/handle_errors.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace debate;
+using strv = std::string_view;
+using u32  = std::uint32_t;
+
+/**
+ * Wire format. Client and server are on the same machine, so every integer is a native-endian
+ * u32. A string is a u32 length followed by its bytes. Each message is prefixed by its length:
+ *
+ *      request:   magic, version, word_count, string[word_count]
+ *      response:  magic, status, text, error_kind, usage,
+ *                 subcommand_count, string[subcommand_count],
+ *                 binding_count, binding[binding_count]
+ *      binding:   parser_depth, argument_index, argument, spelling, value
+ */
+
+namespace {
+
+constexpr u32 wire_magic   = 0x56'52'42'44;  // "DBRV"
+constexpr u32 wire_version = 1;
+/// Larger messages are rejected, so that a misbehaving peer cannot exhaust memory
+constexpr std::size_t max_message_size = 64 * 1024 * 1024;
+
+[[noreturn]] void throw_protocol_error(const char* what) {
+    throw std::system_error(std::make_error_code(std::errc::protocol_error), what);
+}
+
+u32 narrow(std::size_t n) {
+    if (n > max_message_size) {
+        throw_protocol_error("Parser server message is too large");
+    }
+    return static_cast<u32>(n);
+}
+
+/// Builds a length-prefixed message
+struct wire_writer {
+    // Room for the length prefix, which is filled in by finish()
+    std::string out = std::string(sizeof(u32), '\0');
+
+    void put(u32 v) {
+        char buf[sizeof v];
+        std::memcpy(buf, &v, sizeof v);
+        out.append(buf, sizeof v);
+    }
+
+    void put(strv s) {
+        put(narrow(s.size()));
+        out.append(s);
+    }
+
+    const std::string& finish() {
+        auto size = narrow(out.size() - sizeof(u32));
+        std::memcpy(out.data(), &size, sizeof size);
+        return out;
+    }
+};
+
+struct wire_reader {
+    strv in;
+
+    u32 get_u32() {
+        if (in.size() < sizeof(u32)) {
+            throw_protocol_error("Truncated parser server message");
+        }
+        u32 v;
+        std::memcpy(&v, in.data(), sizeof v);
+        in.remove_prefix(sizeof v);
+        return v;
+    }
+
+    strv get_string() {
+        auto size = get_u32();
+        if (size > in.size()) {
+            throw_protocol_error("Truncated parser server message");
+        }
+        auto ret = in.substr(0, size);
+        in.remove_prefix(size);
+        return ret;
+    }
+};
+
+std::string encode_result(const remote_parse_result& res) {
+    wire_writer w;
+    w.put(wire_magic);
+    w.put(static_cast<u32>(res.status));
+    w.put(res.text);
+    w.put(res.error_kind);
+    w.put(res.usage);
+    w.put(narrow(res.subcommands.size()));
+    for (auto& sub : res.subcommands) {
+        w.put(sub);
+    }
+    w.put(narrow(res.bindings.size()));
+    for (auto& b : res.bindings) {
+        w.put(narrow(b.parser_depth));
+        w.put(narrow(b.argument_index));
+        w.put(b.argument);
+        w.put(b.spelling);
+        w.put(b.value);
+    }
+    return w.finish();
+}
+
+remote_parse_result decode_result(strv message) {
+    wire_reader         r{message};
+    remote_parse_result res;
+    if (r.get_u32() != wire_magic) {
+        throw_protocol_error("Invalid parser server response");
+    }
+    auto status = r.get_u32();
+    if (status > static_cast<u32>(remote_status::error)) {
+        throw_protocol_error("Invalid parser server response");
+    }
+    res.status     = static_cast<remote_status>(status);
+    res.text       = r.get_string();
+    res.error_kind = r.get_string();
+    res.usage      = r.get_string();
+    for (auto n = r.get_u32(); n > 0; --n) {
+        res.subcommands.emplace_back(r.get_string());
+    }
+    for (auto n = r.get_u32(); n > 0; --n) {
+        auto& b          = res.bindings.emplace_back();
+        b.parser_depth   = r.get_u32();
+        b.argument_index = r.get_u32();
+        b.argument       = r.get_string();
+        b.spelling       = r.get_string();
+        b.value          = r.get_string();
+    }
+    return res;
+}
+
+/// The name of the exception type, for the most common parsing errors
+strv error_kind_of(const std::exception& e) {
+    if (dynamic_cast<const unknown_argument*>(&e)) {
+        return "unknown_argument";
+    } else if (dynamic_cast<const missing_argument*>(&e)) {
+        return "missing_argument";
+    } else if (dynamic_cast<const missing_argument_value*>(&e)) {
+        return "missing_argument_value";
+    } else if (dynamic_cast<const invalid_argument_value*>(&e)) {
+        return "invalid_argument_value";
+    } else if (dynamic_cast<const invalid_argument_repetition*>(&e)) {
+        return "invalid_argument_repetition";
+    } else if (dynamic_cast<const conflicting_arguments*>(&e)) {
+        return "conflicting_arguments";
+    } else if (dynamic_cast<const invalid_argument_params*>(&e)) {
+        return "invalid_argument_params";
+    }
+    return "exception";
+}
+
+/// Records the subcommands and bindings of a parse
+struct result_recorder : parse_observer {
+    remote_parse_result& res;
+
+    explicit result_recorder(remote_parse_result& r)
+        : res(r) {}
+
+    void on_event(const parse_event& ev) override {
+        if (ev.kind == parse_event_kind::value_bound) {
+            res.bindings.push_back(remote_binding{
+                .parser_depth   = ev.parser_depth,
+                .argument_index = ev.argument_index,
+                .argument       = std::string(ev.arg->preferred_name()),
+                .spelling       = std::string(ev.spelling),
+                .value          = std::string(ev.value),
+            });
+        } else if (ev.kind == parse_event_kind::subparser_entered) {
+            res.subcommands.emplace_back(ev.spelling);
+        }
+    }
+};
+
+remote_parse_result
+run_parse(const argument_parser& parser,
+          const help_index&      help,
+          parse_context&         ctx,
+          std::span<const strv>  words) {
+    remote_parse_result res;
+    result_recorder     recorder{res};
+    boost::leaf::try_catch(
+        [&] { parser.parse_args(words, {.observer = &recorder, .context = &ctx}); },
+        [&](help_request h, e_argument_parser p) {
+            res.status = remote_status::help;
+            res.text   = p.value.help_string(h.category);
+        },
+        [&](const help_search_request& req) {
+            res.status = remote_status::help;
+            res.text   = help_search_string(help.search(req.terms));
+        },
+        [&](const std::exception& e, const e_argument_parser* p) {
+            res.status     = remote_status::error;
+            res.text       = e.what();
+            res.error_kind = error_kind_of(e);
+            if (p) {
+                res.usage = p->value.usage_string(general);
+            }
+        });
+    if (res.status != remote_status::ok) {
+        res.subcommands.clear();
+        res.bindings.clear();
+    }
+    return res;
+}
+
+#ifndef _WIN32
+
+[[noreturn]] void throw_errno(const char* what) {
+    throw std::system_error(errno, std::system_category(), what);
+}
+
+#ifdef MSG_NOSIGNAL
+// A client that goes away must not kill the server with SIGPIPE
+constexpr int send_flags = MSG_NOSIGNAL;
+#else
+constexpr int send_flags = 0;
+#endif
+
+/// An owned file descriptor
+class unique_fd {
+    int _fd = -1;
+
+public:
+    unique_fd() = default;
+    explicit unique_fd(int fd) noexcept
+        : _fd(fd) {}
+    unique_fd(unique_fd&& o) noexcept
+        : _fd(std::exchange(o._fd, -1)) {}
+    unique_fd& operator=(unique_fd&& o) noexcept {
+        std::swap(_fd, o._fd);
+        return *this;
+    }
+    ~unique_fd() {
+        if (_fd >= 0) {
+            ::close(_fd);
+        }
+    }
+
+    int get() const noexcept { return _fd; }
+};
+
+sockaddr_un make_address(const std::filesystem::path& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    auto& native    = path.native();
+    if (native.size() >= sizeof(addr.sun_path)) {
+        throw std::system_error(std::make_error_code(std::errc::filename_too_long),
+                                "Parser server socket path is too long");
+    }
+    std::memcpy(addr.sun_path, native.data(), native.size());
+    return addr;
+}
+
+unique_fd make_socket() {
+    unique_fd fd{::socket(AF_UNIX, SOCK_STREAM, 0)};
+    if (fd.get() < 0) {
+        throw_errno("Failed to create a Unix domain socket");
+    }
+    return fd;
+}
+
+void write_all(int fd, strv data) {
+    while (not data.empty()) {
+        auto n = ::send(fd, data.data(), data.size(), send_flags);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("Failed to write to the parser server socket");
+        }
+        data.remove_prefix(static_cast<std::size_t>(n));
+    }
+}
+
+/// Make reads and writes on the socket fail if they block for longer than the timeout
+void set_timeout(int fd, std::chrono::milliseconds timeout) {
+    if (timeout.count() <= 0) {
+        return;
+    }
+    auto    secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    timeval tv{
+        .tv_sec  = static_cast<decltype(tv.tv_sec)>(secs.count()),
+        .tv_usec = static_cast<decltype(tv.tv_usec)>((timeout - secs).count() * 1000),
+    };
+    for (int opt : {SO_RCVTIMEO, SO_SNDTIMEO}) {
+        if (::setsockopt(fd, SOL_SOCKET, opt, &tv, sizeof tv) != 0) {
+            throw_errno("Failed to set the parser server socket timeout");
+        }
+    }
+}
+
+/// Whether a server is accepting connections on the socket at the given address
+bool is_listening(const sockaddr_un& addr) {
+    auto sock = make_socket();
+    while (::connect(sock.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0) {
+        if (errno != EINTR) {
+            if (errno == ECONNREFUSED or errno == ENOENT) {
+                return false;
+            }
+            throw_errno("Failed to check for a running parser server");
+        }
+    }
+    return true;
+}
+
+void read_all(int fd, char* out, std::size_t size) {
+    while (size != 0) {
+        auto n = ::recv(fd, out, size, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("Failed to read from the parser server socket");
+        }
+        if (n == 0) {
+            throw_protocol_error("Parser server connection closed early");
+        }
+        out += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
+
+std::string read_message(int fd) {
+    u32 size;
+    read_all(fd, reinterpret_cast<char*>(&size), sizeof size);
+    if (size > max_message_size) {
+        throw_protocol_error("Parser server message is too large");
+    }
+    std::string ret(size, '\0');
+    read_all(fd, ret.data(), ret.size());
+    return ret;
+}
+
+#endif
+
+}  // namespace
+
+struct detail::parser_server_data {
+    argument_parser           parser;
+    std::filesystem::path     socket_path;
+    std::chrono::milliseconds io_timeout{};
+    parse_context             context;
+    std::vector<strv>         words;
+    /// Builds itself on the first `--help-search`, and is kept for the following ones
+    help_index help;
+#ifndef _WIN32
+    unique_fd listener;
+    /// serve() also waits on the read end. stop() writes to the other end to wake it.
+    unique_fd stop_read;
+    unique_fd stop_write;
+#endif
+
+    explicit parser_server_data(argument_parser p)
+        : parser(std::move(p))
+        , help(parser) {}
+};
+
+#ifdef _WIN32
+
+parser_server::parser_server(argument_parser, params::for_parser_server) {
+    throw std::system_error(std::make_error_code(std::errc::not_supported),
+                            "The parser server is not supported on Windows");
+}
+
+void parser_server::serve_one() {}
+void parser_server::serve() {}
+void parser_server::stop() noexcept {}
+
+remote_parse_result debate::remote_parse(const std::filesystem::path&, std::span<const strv>) {
+    throw std::system_error(std::make_error_code(std::errc::not_supported),
+                            "The parser server is not supported on Windows");
+}
+
+#else
+
+parser_server::parser_server(argument_parser parser, params::for_parser_server params)
+    : _data(std::make_unique<detail::parser_server_data>(std::move(parser))) {
+    auto& data       = *_data;
+    data.socket_path = std::move(params.socket_path);
+    data.io_timeout  = params.io_timeout;
+
+    auto addr = make_address(data.socket_path);
+    // Replace the socket of a server that exited without cleaning up, but not that of one that
+    // is still running
+    std::error_code ec;
+    if (std::filesystem::is_socket(data.socket_path, ec)) {
+        if (is_listening(addr)) {
+            throw std::system_error(std::make_error_code(std::errc::address_in_use),
+                                    "Another parser server is listening on the socket");
+        }
+        std::filesystem::remove(data.socket_path, ec);
+    }
+    data.listener = make_socket();
+    if (::bind(data.listener.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0) {
+        throw_errno("Failed to bind the parser server socket");
+    }
+    if (::listen(data.listener.get(), SOMAXCONN) != 0) {
+        throw_errno("Failed to listen on the parser server socket");
+    }
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        throw_errno("Failed to create a pipe");
+    }
+    data.stop_read  = unique_fd{fds[0]};
+    data.stop_write = unique_fd{fds[1]};
+}
+
+void parser_server::serve_one() {
+    auto&     data = *_data;
+    unique_fd conn;
+    while (conn.get() < 0) {
+        conn = unique_fd{::accept(data.listener.get(), nullptr, nullptr)};
+        if (conn.get() < 0 and errno != EINTR) {
+            throw_errno("Failed to accept a parser server connection");
+        }
+    }
+    try {
+        set_timeout(conn.get(), data.io_timeout);
+        auto        request = read_message(conn.get());
+        wire_reader r{request};
+        if (r.get_u32() != wire_magic or r.get_u32() != wire_version) {
+            throw_protocol_error("Invalid parser server request");
+        }
+        // The words are views into the request, which outlives the parse
+        data.words.clear();
+        for (auto n = r.get_u32(); n > 0; --n) {
+            data.words.push_back(r.get_string());
+        }
+        auto res = run_parse(data.parser, data.help, data.context, data.words);
+        write_all(conn.get(), encode_result(res));
+    } catch (const std::system_error&) {
+        // The client went away or sent garbage. Drop it, but keep serving others.
+    }
+}
+
+void parser_server::serve() {
+    auto& data = *_data;
+    for (;;) {
+        pollfd fds[2] = {
+            {.fd = data.listener.get(), .events = POLLIN, .revents = 0},
+            {.fd = data.stop_read.get(), .events = POLLIN, .revents = 0},
+        };
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("Failed to wait for parser server connections");
+        }
+        if (fds[1].revents != 0) {
+            char c;
+            [[maybe_unused]] auto n = ::read(data.stop_read.get(), &c, 1);
+            return;
+        }
+        if (fds[0].revents != 0) {
+            serve_one();
+        }
+    }
+}
+
+void parser_server::stop() noexcept {
+    if (_data) {
+        char c = 0;
+        // write() is async-signal-safe
+        [[maybe_unused]] auto n = ::write(_data->stop_write.get(), &c, 1);
+    }
+}
+
+remote_parse_result debate::remote_parse(const std::filesystem::path&      socket_path,
+                                         std::span<const std::string_view> argv) {
+    auto addr = make_address(socket_path);
+    auto sock = make_socket();
+    while (::connect(sock.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof addr) != 0) {
+        if (errno != EINTR) {
+            throw_errno("Failed to connect to the parser server");
+        }
+    }
+    wire_writer w;
+    w.put(wire_magic);
+    w.put(wire_version);
+    w.put(narrow(argv.size()));
+    for (auto word : argv) {
+        w.put(word);
+    }
+    write_all(sock.get(), w.finish());
+    return decode_result(read_message(sock.get()));
+}
+
+#endif
+
+parser_server::parser_server(parser_server&&) noexcept = default;
+
+parser_server& parser_server::operator=(parser_server&& o) noexcept {
+    if (this != &o) {
+        _remove_socket();
+        _data = std::move(o._data);
+    }
+    return *this;
+}
+
+parser_server::~parser_server() { _remove_socket(); }
+
+void parser_server::_remove_socket() noexcept {
+#ifndef _WIN32
+    if (_data) {
+        std::error_code ec;
+        std::filesystem::remove(_data->socket_path, ec);
+    }
+#endif
+}
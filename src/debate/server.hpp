@@ -0,0 +1,120 @@
+#pragma once
+
+#include "./argument_parser.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace debate {
+
+namespace params {
+
+struct for_parser_server {
+    /// The path of the Unix domain socket to listen on. A socket at the path that no server is
+    /// listening on is replaced.
+    std::filesystem::path socket_path;
+    /// A client that takes longer than this to send its request or to receive the response is
+    /// dropped, so that it cannot stall the server. Zero waits forever.
+    std::chrono::milliseconds io_timeout = std::chrono::seconds{5};
+};
+
+}  // namespace params
+
+/// A value that was bound to an argument during a remote parse
+struct remote_binding {
+    /// The depth of the parser that owns the argument. Zero is the top-level parser.
+    std::size_t parser_depth;
+    /// The ordinal of the argument within its parser
+    std::size_t argument_index;
+    /// The preferred name of the argument
+    std::string argument;
+    /// The name by which the argument was selected
+    std::string spelling;
+    std::string value;
+};
+
+enum class remote_status : std::uint8_t {
+    /// The command line was parsed successfully
+    ok = 0,
+    /// Help was requested. The text is the rendered help.
+    help = 1,
+    /// Parsing failed. The text is the error message.
+    error = 2,
+};
+
+/**
+ * @brief The outcome of parsing a command line on a parser_server
+ */
+struct remote_parse_result {
+    remote_status status = remote_status::ok;
+    /// The subcommands that were selected, in order
+    std::vector<std::string> subcommands;
+    /// Every value that was bound, in the order they were given
+    std::vector<remote_binding> bindings;
+    /// The rendered help text, or the error message
+    std::string text;
+    /// For errors, the name of the exception type (e.g. "unknown_argument")
+    std::string error_kind;
+    /// For errors, the rendered usage string of the parser that saw the error
+    std::string usage;
+};
+
+namespace detail {
+
+struct parser_server_data;
+
+}  // namespace detail
+
+/**
+ * @brief Keeps a parser tree resident in a long-lived process and parses command lines sent by
+ * remote_parse() over a Unix domain socket.
+ *
+ * A front-end program that is started very often can forward its argv to the server instead of
+ * building its parser tree on every invocation. The server's parser runs its actions as usual,
+ * so it is normally built with null actions; the client applies the bindings in the result.
+ *
+ * Requests are answered one at a time. Not available on Windows.
+ */
+class parser_server {
+    std::unique_ptr<detail::parser_server_data> _data;
+
+    void _remove_socket() noexcept;
+
+public:
+    /**
+     * @brief Create the socket and start listening.
+     *
+     * @throws std::system_error if the socket cannot be created, or if another server is
+     * already listening on it
+     */
+    parser_server(argument_parser parser, params::for_parser_server params);
+    parser_server(parser_server&&) noexcept;
+    parser_server& operator=(parser_server&&) noexcept;
+    /// Closes the socket and removes it from the filesystem. Assigning to a server does the same
+    /// to the server being replaced.
+    ~parser_server();
+
+    /// Wait for one client and answer its request
+    void serve_one();
+    /// Answer clients until stop() is called
+    void serve();
+    /// Make serve() return. May be called from any thread, or from a signal handler.
+    void stop() noexcept;
+};
+
+/**
+ * @brief Parse a command line on the parser_server listening at the given socket.
+ *
+ * @throws std::system_error if the server cannot be reached. A program may then fall back to
+ * building its parser locally.
+ */
+remote_parse_result remote_parse(const std::filesystem::path&      socket_path,
+                                 std::span<const std::string_view> argv);
+
+}  // namespace debate
@@ -0,0 +1,147 @@
+#include "./server.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+debate::argument_parser build_tree() {
+    debate::argument_parser p{{.prog = "tool"}};
+    p.add_argument({
+        .names       = {"--verbose", "-v"},
+        .action      = debate::null_action,
+        .can_repeat  = true,
+        .wants_value = false,
+        .help        = "Print more output",
+    });
+    auto grp = p.add_subparsers({.action = debate::null_action});
+    auto run = grp.add_parser({.name = "run"});
+    run.add_argument({.names = {"--jobs", "-j"}, .action = debate::null_action});
+    run.add_argument({.names = {"target"}, .action = debate::null_action});
+    return p;
+}
+
+std::filesystem::path socket_path(std::string_view name) {
+    return std::filesystem::temp_directory_path()
+        / ("debate-test-" + std::string(name) + "-" + std::to_string(::getpid()) + ".sock");
+}
+
+/// Connect to the socket at the given path, or bind it if `bind` is true, and return the fd
+int raw_socket(const std::filesystem::path& path, bool bind) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    path.native().copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    int  fd  = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    auto ptr = reinterpret_cast<const sockaddr*>(&addr);
+    REQUIRE((bind ? ::bind(fd, ptr, sizeof addr) : ::connect(fd, ptr, sizeof addr)) == 0);
+    return fd;
+}
+
+}  // namespace
+
+TEST_CASE("Parse on a parser server") {
+    auto path = std::filesystem::temp_directory_path()
+        / ("debate-test-" + std::to_string(::getpid()) + ".sock");
+    auto parse = [&](std::vector<std::string_view> argv) {
+        return debate::remote_parse(path, argv);
+    };
+
+    std::optional<debate::parser_server> server;
+    server.emplace(build_tree(), debate::params::for_parser_server{.socket_path = path});
+    std::thread thread{[&] { server->serve(); }};
+
+    auto res = parse({"-v", "run", "--jobs=4", "all"});
+    CHECK(res.status == debate::remote_status::ok);
+    CHECK(res.subcommands == std::vector<std::string>{"run"});
+    REQUIRE(res.bindings.size() == 3);
+    CHECK(res.bindings[0].argument == "--verbose");
+    CHECK(res.bindings[0].spelling == "-v");
+    CHECK(res.bindings[1].parser_depth == 1);
+    CHECK(res.bindings[1].argument_index == 0);
+    CHECK(res.bindings[1].value == "4");
+    CHECK(res.bindings[2].argument == "target");
+    CHECK(res.bindings[2].value == "all");
+
+    res = parse({"--help"});
+    CHECK(res.status == debate::remote_status::help);
+    CHECK(res.text.find("Print more output") != std::string::npos);
+
+    res = parse({"--help-search", "jobs"});
+    CHECK(res.status == debate::remote_status::help);
+    CHECK(res.text.find("run --jobs") == 0);
+
+    res = parse({"run", "--bogus"});
+    CHECK(res.status == debate::remote_status::error);
+    CHECK(res.error_kind == "unknown_argument");
+    CHECK(res.usage.find("--jobs") != std::string::npos);
+    CHECK(res.bindings.empty());
+
+    // The server keeps the same tree between requests
+    for (int i = 0; i < 20; ++i) {
+        CHECK(parse({"run", "t" + std::to_string(i)}).bindings.at(0).value
+              == "t" + std::to_string(i));
+    }
+
+    server->stop();
+    thread.join();
+    // The socket is removed with the server
+    server.reset();
+    CHECK_FALSE(std::filesystem::exists(path));
+    CHECK_THROWS_AS(parse({"run"}), std::system_error);
+}
+
+TEST_CASE("Parser server sockets") {
+    auto path = socket_path("sockets");
+
+    // A socket that was left behind by a server that is gone is replaced
+    ::close(raw_socket(path, true));
+    REQUIRE(std::filesystem::is_socket(path));
+    std::optional<debate::parser_server> server;
+    server.emplace(build_tree(),
+                   debate::params::for_parser_server{
+                       .socket_path = path,
+                       .io_timeout  = std::chrono::milliseconds{100},
+                   });
+    std::thread thread{[&] { server->serve(); }};
+
+    // The socket of a running server is not
+    CHECK_THROWS_AS(debate::parser_server(build_tree(), {.socket_path = path}),
+                    std::system_error);
+
+    // A client that never sends its request does not stall the others
+    int idle = raw_socket(path, false);
+    std::vector<std::string_view> argv = {"run", "x"};
+    CHECK(debate::remote_parse(path, argv).bindings.at(0).value == "x");
+    ::close(idle);
+
+    server->stop();
+    thread.join();
+
+    // Replacing a server removes the socket of the old one
+    auto other = socket_path("sockets-other");
+    *server    = debate::parser_server(build_tree(), {.socket_path = other});
+    CHECK_FALSE(std::filesystem::exists(path));
+    CHECK(std::filesystem::is_socket(other));
+    server.reset();
+    CHECK_FALSE(std::filesystem::exists(other));
+}
+
+TEST_CASE("Connecting to a missing parser server") {
+    auto path = std::filesystem::temp_directory_path() / "debate-test-missing.sock";
+    std::vector<std::string_view> argv = {"--help"};
+    CHECK_THROWS_AS(debate::remote_parse(path, argv), std::system_error);
+}
+
+#endif
@@ -0,0 +1,579 @@
+#include "./snapshot.hpp"
+
+#include "./detail/parser_impl.hpp"
+#include "./error.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+using namespace debate;
+using strv = std::string_view;
+using u32  = std::uint32_t;
+
+/**
+ * Image layout. Every field is a native-endian u32, so records have no padding and can be copied
+ * in and out with memcpy regardless of the alignment of the image:
+ *
+ *      header
+ *      parser_rec[parser_count]      (index 0 is the root)
+ *      argument_rec[argument_count]  (in ordinal order)
+ *      argument_group_rec[argument_group_count]
+ *      u32[group_ref_count]          (argument group indices of the groups attached to parsers)
+ *      str_ref[name_count]           (argument names)
+ *      str_ref[choice_count]         (accepted argument values)
+ *      constraint_rec[constraint_count]
+ *      u32[constrained_count]        (constrained arguments, relative to their parser's first)
+ *      u32[child_count]              (parser indices of subparsers)
+ *      char[strings_size]            (string data)
+ */
+
+namespace {
+
+constexpr u32 snapshot_magic   = 0x50'41'4e'53;  // "SNAP"
+constexpr u32 snapshot_version = 5;
+constexpr u32 absent           = ~u32{0};
+
+struct str_ref {
+    u32 offset = absent;
+    u32 size   = 0;
+};
+
+struct header {
+    u32 magic;
+    u32 version;
+    u32 parser_count;
+    u32 argument_count;
+    u32 argument_group_count;
+    u32 group_ref_count;
+    u32 name_count;
+    u32 choice_count;
+    u32 constraint_count;
+    u32 constrained_count;
+    u32 child_count;
+    u32 strings_size;
+};
+
+struct parser_rec {
+    str_ref prog;
+    str_ref description;
+    str_ref epilog;
+    /// The subcommand name of this parser within its parent
+    str_ref name;
+    u32     category;
+
+    /// The parser's own arguments
+    u32 first_argument;
+    u32 argument_count;
+    /// The argument groups attached to the parser, which are stored once however many parsers
+    /// they are attached to
+    u32 first_group_ref;
+    u32 group_ref_count;
+
+    u32 first_constraint;
+    u32 constraint_count;
+
+    u32     has_group;
+    u32     group_ordinal;
+    u32     group_required;
+    str_ref group_title;
+    str_ref group_description;
+    u32     first_child;
+    u32     child_count;
+};
+
+enum argument_flags : u32 {
+    flag_can_repeat  = 1 << 0,
+    flag_required    = 1 << 1,
+    flag_wants_value = 1 << 2,
+};
+
+struct argument_rec {
+    u32     first_name;
+    u32     name_count;
+    str_ref metavar;
+    str_ref help;
+    u32     flags;
+    u32     category;
+    /// The value count, or `absent` in nargs_min if there is none. An unlimited max is `absent`.
+    u32 nargs_min;
+    u32 nargs_max;
+    /// The delimiter character, or `absent`
+    u32 delimiter;
+    /// The accepted values. A count of zero accepts any value.
+    u32 first_choice;
+    u32 choice_count;
+};
+
+struct argument_group_rec {
+    u32 first_argument;
+    u32 argument_count;
+};
+
+struct constraint_rec {
+    u32 kind;
+    u32 first_argument;
+    u32 argument_count;
+};
+
+static_assert(std::is_trivially_copyable_v<parser_rec> and sizeof(parser_rec) % sizeof(u32) == 0);
+static_assert(std::is_trivially_copyable_v<argument_rec>
+              and sizeof(argument_rec) % sizeof(u32) == 0);
+static_assert(std::is_trivially_copyable_v<argument_group_rec>
+              and sizeof(argument_group_rec) % sizeof(u32) == 0);
+static_assert(std::is_trivially_copyable_v<constraint_rec>
+              and sizeof(constraint_rec) % sizeof(u32) == 0);
+
+u32 narrow(std::size_t n) {
+    if (n >= absent) {
+        throw invalid_argument_params{"Parser tree is too large to be saved as a snapshot"};
+    }
+    return static_cast<u32>(n);
+}
+
+struct snapshot_writer {
+    std::vector<parser_rec>         parsers;
+    std::vector<argument_rec>       arguments;
+    std::vector<argument_group_rec> argument_groups;
+    std::vector<u32>                group_refs;
+    std::vector<str_ref>            names;
+    std::vector<str_ref>            choices;
+    std::vector<constraint_rec>     constraints;
+    std::vector<u32>                constrained;
+    std::vector<u32>                children;
+    std::string                     strings;
+    u32                             group_count = 0;
+
+    // Identical strings (e.g. options shared by many subcommands) are stored only once
+    std::unordered_map<std::string, str_ref> interned;
+
+    str_ref add_string(strv s) {
+        auto found = interned.find(std::string(s));
+        if (found != interned.end()) {
+            return found->second;
+        }
+        str_ref ref{narrow(strings.size()), narrow(s.size())};
+        strings.append(s);
+        interned.emplace(std::string(s), ref);
+        return ref;
+    }
+
+    // The index of each argument group that has been stored
+    std::unordered_map<const detail::argument_parser_impl*, u32> group_indices;
+
+    str_ref add_opt_string(std::optional<strv> s) { return s ? add_string(*s) : str_ref{}; }
+
+    void add_arguments(std::span<const argument> args) {
+        for (const argument& arg : args) {
+            argument_rec arec{};
+            arec.first_name = narrow(names.size());
+            arec.name_count = narrow(arg.names().size());
+            for (auto& n : arg.names()) {
+                names.push_back(add_string(n));
+            }
+            arec.metavar  = add_opt_string(arg.metavar());
+            arec.help     = add_opt_string(arg.help());
+            arec.flags    = (arg.can_repeat() ? flag_can_repeat : 0u)
+                | (arg.is_required() ? flag_required : 0u)
+                | (arg.wants_value() ? flag_wants_value : 0u);
+            arec.category = static_cast<u32>(arg.category());
+
+            arec.nargs_min = absent;
+            arec.nargs_max = absent;
+            arec.delimiter = absent;
+            if (auto count = arg.nargs()) {
+                arec.nargs_min = narrow(count->min);
+                if (count->max != value_count::unlimited) {
+                    arec.nargs_max = narrow(count->max);
+                }
+            }
+            if (auto delim = arg.delimiter()) {
+                arec.delimiter = static_cast<unsigned char>(*delim);
+            }
+            arec.first_choice = narrow(choices.size());
+            if (auto& set = arg.choices()) {
+                arec.choice_count = narrow(set->size());
+                for (auto& word : set->words()) {
+                    choices.push_back(add_string(word));
+                }
+            }
+            arguments.push_back(arec);
+        }
+    }
+
+    u32 add_parser(const detail::argument_parser_impl& impl, strv name, category cat) {
+        auto idx = narrow(parsers.size());
+        parsers.emplace_back();
+
+        parser_rec rec{};
+        rec.prog           = add_opt_string(impl.params.prog);
+        rec.description    = add_opt_string(impl.params.description);
+        rec.epilog         = add_opt_string(impl.params.epilog);
+        rec.name           = add_string(name);
+        rec.category       = static_cast<u32>(cat);
+        rec.first_argument = narrow(arguments.size());
+        rec.argument_count = narrow(impl.arguments.size());
+        add_arguments(impl.arguments);
+
+        // A group's arguments are stored when the group is first seen, and shared after that
+        rec.first_group_ref = narrow(group_refs.size());
+        rec.group_ref_count = narrow(impl.groups.size());
+        for (auto& grp : impl.groups) {
+            auto [found, added] = group_indices.emplace(grp.get(), narrow(argument_groups.size()));
+            if (added) {
+                argument_groups.push_back(argument_group_rec{
+                    .first_argument = narrow(arguments.size()),
+                    .argument_count = narrow(grp->arguments.size()),
+                });
+                add_arguments(grp->arguments);
+            }
+            group_refs.push_back(found->second);
+        }
+
+        // Constraint ordinals index the parser's own arguments
+        rec.first_constraint = narrow(constraints.size());
+        rec.constraint_count = narrow(impl.constraints.size());
+        for (auto& con : impl.constraints) {
+            constraints.push_back(constraint_rec{
+                .kind           = static_cast<u32>(con.def.kind),
+                .first_argument = narrow(constrained.size()),
+                .argument_count = narrow(con.ordinals.size()),
+            });
+            for (auto ordinal : con.ordinals) {
+                constrained.push_back(narrow(ordinal));
+            }
+        }
+
+        std::vector<u32> kids;
+        if (impl.subparsers) {
+            auto& grp             = *impl.subparsers;
+            rec.has_group         = 1;
+            rec.group_ordinal     = group_count++;
+            rec.group_required    = grp.required ? 1 : 0;
+            rec.group_title       = add_string(grp.title);
+            rec.group_description = add_opt_string(grp.description);
+            for (auto& [key, sub] : grp.parsers) {
+                kids.push_back(
+                    add_parser(detail::argument_parser_impl::extract(sub.get()), key, sub.cat));
+            }
+        }
+        rec.first_child = narrow(children.size());
+        rec.child_count = narrow(kids.size());
+        children.insert(children.end(), kids.begin(), kids.end());
+        parsers[idx] = rec;
+        return idx;
+    }
+
+    template <typename T>
+    static void append_pod(std::string& out, const T& value) {
+        char buf[sizeof(T)];
+        std::memcpy(buf, &value, sizeof(T));
+        out.append(buf, sizeof(T));
+    }
+
+    std::string finish() const {
+        header hdr{
+            .magic                = snapshot_magic,
+            .version              = snapshot_version,
+            .parser_count         = narrow(parsers.size()),
+            .argument_count       = narrow(arguments.size()),
+            .argument_group_count = narrow(argument_groups.size()),
+            .group_ref_count      = narrow(group_refs.size()),
+            .name_count           = narrow(names.size()),
+            .choice_count         = narrow(choices.size()),
+            .constraint_count     = narrow(constraints.size()),
+            .constrained_count    = narrow(constrained.size()),
+            .child_count          = narrow(children.size()),
+            .strings_size         = narrow(strings.size()),
+        };
+        std::string out;
+        append_pod(out, hdr);
+        for (auto& r : parsers) {
+            append_pod(out, r);
+        }
+        for (auto& r : arguments) {
+            append_pod(out, r);
+        }
+        for (auto& r : argument_groups) {
+            append_pod(out, r);
+        }
+        for (auto& r : group_refs) {
+            append_pod(out, r);
+        }
+        for (auto& r : names) {
+            append_pod(out, r);
+        }
+        for (auto& r : choices) {
+            append_pod(out, r);
+        }
+        for (auto& r : constraints) {
+            append_pod(out, r);
+        }
+        for (auto& r : constrained) {
+            append_pod(out, r);
+        }
+        for (auto& r : children) {
+            append_pod(out, r);
+        }
+        out.append(strings);
+        return out;
+    }
+};
+
+class snapshot_reader : public std::enable_shared_from_this<snapshot_reader> {
+    strv                      _image;
+    header                    _hdr;
+    std::size_t               _parsers_off     = 0;
+    std::size_t               _arguments_off   = 0;
+    std::size_t               _groups_off      = 0;
+    std::size_t               _group_refs_off  = 0;
+    std::size_t               _names_off       = 0;
+    std::size_t               _choices_off     = 0;
+    std::size_t               _constraints_off = 0;
+    std::size_t               _constrained_off = 0;
+    std::size_t               _children_off    = 0;
+    strv                      _strings;
+    params::for_snapshot_load _params;
+
+    // Argument groups are created when the first parser that has them is loaded. Subparsers may
+    // be loaded from several threads at once.
+    std::mutex                                _groups_mutex;
+    std::vector<std::optional<argument_group>> _groups;
+
+    template <typename T>
+    T _read(std::size_t table_offset, u32 index, u32 count) const {
+        if (index >= count) {
+            throw invalid_snapshot{"Snapshot record index is out of bounds"};
+        }
+        T ret;
+        std::memcpy(&ret, _image.data() + table_offset + index * sizeof(T), sizeof(T));
+        return ret;
+    }
+
+    std::optional<strv> _opt_string(str_ref ref) const {
+        if (ref.offset == absent) {
+            return std::nullopt;
+        }
+        if (ref.offset > _strings.size() or ref.size > _strings.size() - ref.offset) {
+            throw invalid_snapshot{"Snapshot string is out of bounds"};
+        }
+        return _strings.substr(ref.offset, ref.size);
+    }
+
+    strv _string(str_ref ref) const { return _opt_string(ref).value_or(strv{}); }
+
+    opt_string _opt_owned(str_ref ref) const {
+        auto s = _opt_string(ref);
+        return s ? opt_string{std::string(*s)} : std::nullopt;
+    }
+
+    static category _category(u32 value) {
+        if (value > static_cast<u32>(hidden)) {
+            throw invalid_snapshot{"Snapshot record has an invalid category"};
+        }
+        return static_cast<category>(value);
+    }
+
+    params::for_argument _argument_params(u32 ordinal) const {
+        auto       arec = _read<argument_rec>(_arguments_off, ordinal, _hdr.argument_count);
+        string_vec names;
+        for (u32 n = 0; n < arec.name_count; ++n) {
+            auto ref = _read<str_ref>(_names_off, arec.first_name + n, _hdr.name_count);
+            names.emplace_back(_string(ref));
+        }
+        if (names.empty()) {
+            throw invalid_snapshot{"Snapshot argument has no names"};
+        }
+        argument_action action = null_action;
+        if (_params.bind_argument) {
+            action = _params.bind_argument(ordinal, names.front());
+        }
+        std::optional<value_count> nargs;
+        if (arec.nargs_min != absent) {
+            nargs.emplace(arec.nargs_min,
+                          arec.nargs_max == absent ? value_count::unlimited : arec.nargs_max);
+        }
+        std::optional<char> delimiter;
+        if (arec.delimiter != absent) {
+            delimiter = static_cast<char>(arec.delimiter);
+        }
+        std::optional<choice_set> choices;
+        if (arec.choice_count != 0) {
+            std::vector<std::string> words;
+            for (u32 c = 0; c < arec.choice_count; ++c) {
+                auto ref = _read<str_ref>(_choices_off, arec.first_choice + c, _hdr.choice_count);
+                words.emplace_back(_string(ref));
+            }
+            try {
+                choices.emplace(std::move(words));
+            } catch (const invalid_argument_params&) {
+                throw invalid_snapshot{"Snapshot argument has duplicate choices"};
+            }
+        }
+        return {
+            .names       = std::move(names),
+            .action      = std::move(action),
+            .can_repeat  = (arec.flags & flag_can_repeat) != 0,
+            .required    = (arec.flags & flag_required) != 0,
+            .wants_value = (arec.flags & flag_wants_value) != 0,
+            .choices     = std::move(choices),
+            .nargs       = nargs,
+            .delimiter   = delimiter,
+            .metavar     = _opt_owned(arec.metavar),
+            .help        = _opt_owned(arec.help),
+            .category    = _category(arec.category),
+        };
+    }
+
+    /// Get the argument group with the given index, creating it on first use
+    argument_group _argument_group(u32 index) {
+        auto grec = _read<argument_group_rec>(_groups_off, index, _hdr.argument_group_count);
+        std::lock_guard lk{_groups_mutex};
+        auto&           grp = _groups[index];
+        if (not grp) {
+            argument_group created;
+            for (u32 i = 0; i < grec.argument_count; ++i) {
+                try {
+                    created.add_argument(_argument_params(grec.first_argument + i));
+                } catch (const invalid_argument_params&) {
+                    throw invalid_snapshot{"Snapshot argument group is invalid"};
+                }
+            }
+            grp = std::move(created);
+        }
+        return *grp;
+    }
+
+public:
+    snapshot_reader(strv image, params::for_snapshot_load p)
+        : _image(image)
+        , _params(std::move(p)) {
+        if (image.size() < sizeof(header)) {
+            throw invalid_snapshot{"Snapshot image is truncated"};
+        }
+        std::memcpy(&_hdr, image.data(), sizeof(header));
+        if (_hdr.magic != snapshot_magic or _hdr.version != snapshot_version) {
+            throw invalid_snapshot{"Data is not a compatible parser snapshot"};
+        }
+        _parsers_off     = sizeof(header);
+        _arguments_off   = _parsers_off + _hdr.parser_count * sizeof(parser_rec);
+        _groups_off      = _arguments_off + _hdr.argument_count * sizeof(argument_rec);
+        _group_refs_off  = _groups_off + _hdr.argument_group_count * sizeof(argument_group_rec);
+        _names_off       = _group_refs_off + _hdr.group_ref_count * sizeof(u32);
+        _choices_off     = _names_off + _hdr.name_count * sizeof(str_ref);
+        _constraints_off = _choices_off + _hdr.choice_count * sizeof(str_ref);
+        _constrained_off = _constraints_off + _hdr.constraint_count * sizeof(constraint_rec);
+        _children_off    = _constrained_off + _hdr.constrained_count * sizeof(u32);
+        auto strs_off    = _children_off + _hdr.child_count * sizeof(u32);
+        if (strs_off + _hdr.strings_size != image.size() or _hdr.parser_count == 0) {
+            throw invalid_snapshot{"Snapshot image size does not match its header"};
+        }
+        _strings = image.substr(strs_off);
+        _groups.resize(_hdr.argument_group_count);
+    }
+
+    /// Load the parser with the given index. If `strings` is non-null, the parser shares it.
+    argument_parser load_parser(u32 index, std::shared_ptr<detail::string_pool> strings) {
+        auto rec = _read<parser_rec>(_parsers_off, index, _hdr.parser_count);
+
+        argument_parser parser{{
+            .prog        = _opt_owned(rec.prog),
+            .description = _opt_owned(rec.description),
+            .epilog      = _opt_owned(rec.epilog),
+        }};
+        auto& impl = detail::argument_parser_impl::extract(parser);
+        if (strings) {
+            impl.strings = std::move(strings);
+        }
+        std::vector<argument> added;
+        for (u32 i = 0; i < rec.argument_count; ++i) {
+            added.push_back(parser.add_argument(_argument_params(rec.first_argument + i)));
+        }
+        for (u32 i = 0; i < rec.group_ref_count; ++i) {
+            auto group_idx
+                = _read<u32>(_group_refs_off, rec.first_group_ref + i, _hdr.group_ref_count);
+            try {
+                parser.add_group(_argument_group(group_idx));
+            } catch (const invalid_argument_params&) {
+                throw invalid_snapshot{"Snapshot parser has the same argument group twice"};
+            }
+        }
+
+        for (u32 i = 0; i < rec.constraint_count; ++i) {
+            auto crec = _read<constraint_rec>(_constraints_off,
+                                              rec.first_constraint + i,
+                                              _hdr.constraint_count);
+            if (crec.kind > static_cast<u32>(constraint_kind::dependency)) {
+                throw invalid_snapshot{"Snapshot constraint has an unknown kind"};
+            }
+            std::vector<argument> args;
+            for (u32 n = 0; n < crec.argument_count; ++n) {
+                auto idx = _read<u32>(_constrained_off,
+                                      crec.first_argument + n,
+                                      _hdr.constrained_count);
+                if (idx >= added.size()) {
+                    throw invalid_snapshot{"Snapshot constraint refers to an unknown argument"};
+                }
+                args.push_back(added[idx]);
+            }
+            try {
+                parser.add_constraint({
+                    .kind      = static_cast<constraint_kind>(crec.kind),
+                    .arguments = std::move(args),
+                });
+            } catch (const invalid_argument_params&) {
+                throw invalid_snapshot{"Snapshot constraint is invalid"};
+            }
+        }
+
+        if (rec.has_group) {
+            argument_action action = null_action;
+            if (_params.bind_subparser_group) {
+                action = _params.bind_subparser_group(rec.group_ordinal);
+            }
+            parser.add_subparsers({
+                .title       = std::string(_string(rec.group_title)),
+                .action      = std::move(action),
+                .description = _opt_owned(rec.group_description),
+                .required    = rec.group_required != 0,
+            });
+            for (u32 i = 0; i < rec.child_count; ++i) {
+                auto child_idx = _read<u32>(_children_off, rec.first_child + i, _hdr.child_count);
+                auto child     = _read<parser_rec>(_parsers_off, child_idx, _hdr.parser_count);
+                auto lazy      = std::make_shared<detail::lazy_subparser>();
+                auto parent    = impl.subparsers->parent;
+                auto pool      = impl.pool();
+                lazy->load     = [self = shared_from_this(), child_idx, parent, pool] {
+                    auto p = self->load_parser(child_idx, pool);
+                    detail::argument_parser_impl::extract(p).parent = parent;
+                    return p;
+                };
+                detail::subparser sub{
+                    .cat    = _category(child.category),
+                    .parser = std::nullopt,
+                    .lazy   = std::move(lazy),
+                };
+                impl.subparsers->parsers.emplace(_string(child.name), std::move(sub));
+            }
+        }
+        return parser;
+    }
+};
+
+}  // namespace
+
+std::string debate::save_snapshot(const argument_parser& parser) {
+    snapshot_writer writer;
+    writer.add_parser(detail::argument_parser_impl::extract(parser), "", general);
+    return writer.finish();
+}
+
+argument_parser debate::load_snapshot(std::string_view image, params::for_snapshot_load p) {
+    auto reader = std::make_shared<snapshot_reader>(image, std::move(p));
+    return reader->load_parser(0, nullptr);
+}
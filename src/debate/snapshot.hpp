@@ -0,0 +1,60 @@
+#pragma once
+
+#include "./argument_parser.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace debate {
+
+namespace params {
+
+struct for_snapshot_load {
+    /**
+     * @brief Produce the action for an argument in the snapshot.
+     *
+     * Called with the argument's ordinal and its preferred name. Ordinals are assigned in
+     * depth-first order: the arguments of a parser in the order they were added, then those of
+     * each argument group attached to it that was not already counted for an earlier parser,
+     * followed by those of each of its subparsers, in order of subcommand name. Argument groups
+     * are shared by the loaded parsers just as in the original tree, so each of their arguments
+     * has one ordinal. If null, arguments are given null actions.
+     */
+    std::function<argument_action(std::size_t ordinal, std::string_view name)> bind_argument
+        = nullptr;
+
+    /**
+     * @brief Produce the action for a subparser group in the snapshot.
+     *
+     * Called with the group's ordinal, which counts the parsers that have subparser groups in
+     * the same depth-first order as for arguments. If null, groups are given null actions.
+     */
+    std::function<argument_action(std::size_t ordinal)> bind_subparser_group = nullptr;
+};
+
+}  // namespace params
+
+/**
+ * @brief Serialize an entire parser tree into a compact binary image.
+ *
+ * The image contains the name tables, flags, value counts, choices, constraints, categories,
+ * help text, and subparser index of every parser in the tree, but not the actions, validators,
+ * or default values. It is intended to be generated at build time and embedded into the program
+ * that will load it. The image uses the native byte order and is not portable between platforms.
+ */
+std::string save_snapshot(const argument_parser& parser);
+
+/**
+ * @brief Load a parser tree from an image created by save_snapshot().
+ *
+ * Only the top-level parser is constructed immediately. Each subparser is constructed from the
+ * image the first time it is needed, so a program pays only for the subcommands it actually
+ * uses. The image is not copied, and must outlive the returned parser and all of its subparsers.
+ *
+ * @throws invalid_snapshot if the image is malformed
+ */
+argument_parser load_snapshot(std::string_view image, params::for_snapshot_load = {});
+
+}  // namespace debate
@@ -0,0 +1,201 @@
+#include "./snapshot.hpp"
+
+#include "./error.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+
+using debate::argument_parser;
+
+namespace {
+
+argument_parser build_tree() {
+    argument_parser p{{
+        .prog        = "snapper",
+        .description = "A program that takes pictures",
+        .epilog      = "That's all",
+    }};
+    p.add_argument({
+        .names       = {"--verbose", "-v"},
+        .action      = debate::null_action,
+        .can_repeat  = true,
+        .wants_value = false,
+        .help        = "Be loud",
+    });
+    p.add_argument({
+        .names    = {"--debug-level"},
+        .action   = debate::null_action,
+        .metavar  = "<lvl>",
+        .category = debate::debugging,
+    });
+    auto grp = p.add_subparsers({
+        .title       = "commands",
+        .action      = debate::null_action,
+        .description = "The command to run",
+    });
+    auto take = grp.add_parser({.name = "take", .description = "Take a picture"});
+    take.add_argument({.names = {"subject"}, .action = debate::null_action});
+    take.add_argument({
+        .names    = {"--flash"},
+        .action   = debate::null_action,
+        .required = true,
+        .choices  = debate::choice_set{"on", "off", "auto"},
+    });
+    auto dev = grp.add_parser({.name = "develop", .category = debate::advanced});
+    dev.add_argument({
+        .names      = {"film"},
+        .action     = debate::null_action,
+        .can_repeat = true,
+        .required   = false,
+        .nargs      = '+',
+        .delimiter  = ',',
+    });
+    return p;
+}
+
+}  // namespace
+
+TEST_CASE("Snapshot round-trip") {
+    auto original = build_tree();
+    auto image    = debate::save_snapshot(original);
+
+    std::vector<std::pair<std::size_t, std::string>> seen;
+    std::optional<std::string>                       command;
+
+    auto loaded = debate::load_snapshot(
+        image,
+        {
+            .bind_argument =
+                [&](std::size_t ordinal, std::string_view) {
+                    return [&seen, ordinal](std::string_view, std::string_view value) {
+                        seen.emplace_back(ordinal, std::string(value));
+                    };
+                },
+            .bind_subparser_group =
+                [&](std::size_t) { return debate::store_string(command); },
+        });
+
+    for (auto cat : {debate::general, debate::advanced, debate::debugging}) {
+        CHECK(loaded.help_string(cat) == original.help_string(cat));
+    }
+
+    loaded.parse_args(std::vector<std::string>{"-vv", "take", "--flash=on", "cat"});
+    CHECK(command == "take");
+    // Ordinals: 0=--verbose 1=--debug-level, then 'develop' (2=film), then 'take' (3=subject
+    // 4=--flash), following the sorted order of subcommand names
+    CHECK(seen
+          == std::vector<std::pair<std::size_t, std::string>>{
+              {0, ""},
+              {0, ""},
+              {4, "on"},
+              {3, "cat"},
+          });
+
+    SECTION("Value counts and delimiters are kept") {
+        seen.clear();
+        loaded.parse_args(std::vector<std::string>{"develop", "a,b", "c"});
+        CHECK(seen
+              == std::vector<std::pair<std::size_t, std::string>>{
+                  {2, "a"},
+                  {2, "b"},
+                  {2, "c"},
+              });
+    }
+
+    SECTION("Choices are kept") {
+        CHECK(debate::save_snapshot(loaded) == image);
+        CHECK_THROWS_AS(loaded.parse_args(std::vector<std::string>{"take", "--flash=dim", "cat"}),
+                        debate::invalid_argument_value);
+        seen.clear();
+        loaded.parse_args(std::vector<std::string>{"take", "--flash=auto", "cat"});
+        CHECK(seen.front() == std::pair<std::size_t, std::string>{4, "auto"});
+    }
+
+    SECTION("Missing required arguments are still detected") {
+        CHECK_THROWS_AS(loaded.parse_args(std::vector<std::string>{"take", "cat"}),
+                        debate::missing_argument);
+    }
+}
+
+TEST_CASE("Snapshots keep argument constraints") {
+    argument_parser p;
+    auto add_flag = [&](std::string name) {
+        return p.add_argument({
+            .names       = {name},
+            .action      = debate::null_action,
+            .wants_value = false,
+        });
+    };
+    auto json    = add_flag("--json");
+    auto yaml    = add_flag("--yaml");
+    auto log     = add_flag("--log");
+    auto logfile = add_flag("--log-file");
+    p.add_constraint({.kind = debate::constraint_kind::exactly_one, .arguments = {json, yaml}});
+    p.add_constraint({.kind = debate::constraint_kind::dependency, .arguments = {logfile, log}});
+
+    auto image  = debate::save_snapshot(p);
+    auto loaded = debate::load_snapshot(image);
+    CHECK(debate::save_snapshot(loaded) == image);
+
+    auto parse = [&](std::vector<std::string> argv) { loaded.parse_args(argv); };
+    parse({"--json", "--log-file", "--log"});
+    CHECK_THROWS_AS(parse({"--json", "--yaml"}), debate::conflicting_arguments);
+    CHECK_THROWS_AS(parse({"--log"}), debate::missing_argument);
+    CHECK_THROWS_AS(parse({"--yaml", "--log-file"}), debate::missing_argument);
+}
+
+TEST_CASE("Snapshots share argument groups") {
+    argument_parser p;
+    debate::argument_group common;
+    common.add_argument({.names = {"--color"}, .action = debate::null_action});
+    p.add_group(common);
+    auto grp = p.add_subparsers({.action = debate::null_action});
+    for (auto name : {"build", "test"}) {
+        auto sub = grp.add_parser({.name = name});
+        sub.add_argument({.names = {"--jobs"}, .action = debate::null_action});
+        sub.add_group(common);
+    }
+
+    auto image = debate::save_snapshot(p);
+    std::vector<std::pair<std::size_t, std::string>> seen;
+    auto loaded = debate::load_snapshot(
+        image,
+        {.bind_argument = [&](std::size_t ordinal, std::string_view) {
+            return [&seen, ordinal](std::string_view, std::string_view value) {
+                seen.emplace_back(ordinal, std::string(value));
+            };
+        }});
+    CHECK(debate::save_snapshot(loaded) == image);
+
+    // The group's argument has a single ordinal (0, then 'build --jobs' is 1 and 'test --jobs' is
+    // 2), and is tracked once across the chain, as it is in the original tree
+    loaded.parse_args(std::vector<std::string>{"test", "--color=red", "--jobs=2"});
+    CHECK(seen
+          == std::vector<std::pair<std::size_t, std::string>>{
+              {0, "red"},
+              {2, "2"},
+          });
+    for (auto& tree : {p, loaded}) {
+        CHECK_THROWS_AS(tree.parse_args(
+                            std::vector<std::string>{"--color=red", "build", "--color=blue"}),
+                        debate::invalid_argument_repetition);
+    }
+}
+
+TEST_CASE("Malformed snapshots") {
+    auto image = debate::save_snapshot(build_tree());
+    CHECK_THROWS_AS(debate::load_snapshot(image.substr(0, 10)), debate::invalid_snapshot);
+    CHECK_THROWS_AS(debate::load_snapshot(image.substr(0, image.size() - 1)),
+                    debate::invalid_snapshot);
+    auto bad_magic = image;
+    bad_magic[0]   = 'X';
+    CHECK_THROWS_AS(debate::load_snapshot(bad_magic), debate::invalid_snapshot);
+
+    // The category of the first subcommand: after the 12 words of the header, the 24 words of the
+    // root parser record, and the four strings of the subcommand's record
+    auto bad_category    = image;
+    auto offset          = (12 + 24 + 8) * sizeof(std::uint32_t);
+    bad_category[offset] = 100;
+    CHECK_THROWS_AS(debate::load_snapshot(bad_category), debate::invalid_snapshot);
+}
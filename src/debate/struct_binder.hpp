@@ -0,0 +1,199 @@
+#pragma once
+
+#include "./argument_parser.hpp"
+
+#include <charconv>
+#include <concepts>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace debate {
+
+namespace detail {
+
+template <typename T>
+struct bound_member_traits {
+    /// The type that each value is converted to
+    using value_type = T;
+    /// Whether each value replaces the previous one (false) or is appended to it (true)
+    static constexpr bool appends = false;
+};
+
+template <typename T>
+struct bound_member_traits<std::optional<T>> : bound_member_traits<T> {};
+
+template <typename T, typename Alloc>
+struct bound_member_traits<std::vector<T, Alloc>> {
+    using value_type              = T;
+    static constexpr bool appends = true;
+};
+
+/**
+ * @brief Convert an argument value to a T, using a conversion chosen at compile time from T.
+ *
+ * @throws invalid_argument_value if the value is not a valid T
+ */
+template <typename T>
+T convert_bound_value(std::string_view value) {
+    if constexpr (std::same_as<T, bool>) {
+        if (value == "true" or value == "yes" or value == "on" or value == "1") {
+            return true;
+        }
+        if (value == "false" or value == "no" or value == "off" or value == "0") {
+            return false;
+        }
+        throw invalid_argument_value{std::string(value)};
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        T    out{};
+        auto end         = value.data() + value.size();
+        auto [ptr, errc] = std::from_chars(value.data(), end, out);
+        if (errc != std::errc{} or ptr != end) {
+            throw invalid_argument_value{std::string(value)};
+        }
+        return out;
+    } else if constexpr (std::constructible_from<T, std::string_view>) {
+        return T(value);
+    } else {
+        static_assert(std::constructible_from<T, std::string>,
+                      "The member type cannot be bound: its values cannot be converted from "
+                      "strings");
+        return T(std::string(value));
+    }
+}
+
+/// Store one value into a member, replacing its value or appending to it
+template <typename M>
+void store_bound_value(M& member, std::string_view value) {
+    using traits = bound_member_traits<M>;
+    if constexpr (traits::appends) {
+        member.push_back(convert_bound_value<typename traits::value_type>(value));
+    } else if constexpr (std::same_as<M, std::string>) {
+        // Assign in place, so that the member can reuse its existing capacity
+        member = value;
+    } else {
+        member = convert_bound_value<typename traits::value_type>(value);
+    }
+}
+
+}  // namespace detail
+
+/**
+ * @brief Declares arguments against the data members of a Config struct, and parses command
+ * lines into objects of that type.
+ *
+ * Each bound argument converts its values and stores them directly into the member. The
+ * conversion is chosen at compile time from the member type:
+ *
+ * - `bool` members are flags that take no value and are set to `true` when given.
+ * - `std::string` members are assigned the value.
+ * - Arithmetic members are parsed with `std::from_chars()`.
+ * - `std::optional<T>` members are assigned a converted T.
+ * - `std::vector<T>` members have each converted T appended, and may be given repeatedly.
+ * - Any other member type must be constructible from a `std::string_view` or `std::string`.
+ *
+ * A value that cannot be converted raises invalid_argument_value, including in a parse with
+ * `run_actions = false`, since the conversion of numbers and bools is also installed as part of
+ * the argument's validator. The underlying parser is available from parser() for adding
+ * subparsers, groups and constraints. Since the arguments store into the target of the parse
+ * (see parse_target), one binder can be used to parse into any number of objects concurrently.
+ */
+template <typename Config>
+class struct_binder {
+    argument_parser _parser;
+
+public:
+    struct_binder() = default;
+    explicit struct_binder(params::for_argument_parser p)
+        : _parser(std::move(p)) {}
+
+    /// The parser that holds the bound arguments
+    argument_parser& parser() noexcept { return _parser; }
+    /// The parser that holds the bound arguments
+    const argument_parser& parser() const noexcept { return _parser; }
+
+    /**
+     * @brief Add an argument that stores into the given member. The action of the params is
+     * provided by the binder.
+     *
+     * @throws invalid_argument_params if the params already have an action, if a bool member is
+     * bound to a positional argument, or if another member is bound to an argument that does not
+     * want a value
+     */
+    template <typename M>
+    argument bind(M Config::*member, params::for_argument p) {
+        return bind_to(_parser, member, std::move(p));
+    }
+
+    /**
+     * @brief Add an argument that stores into the given member to another parser, such as a
+     * subparser of parser(). The subparser must be parsed with the same Config target.
+     */
+    template <typename M>
+    static argument bind_to(argument_parser& parser, M Config::*member, params::for_argument p) {
+        if (p.action) {
+            throw invalid_argument_params{"A bound argument must not be given an action"};
+        }
+        if constexpr (std::same_as<M, bool>) {
+            if (p.names.empty() or not p.names.front().starts_with('-')) {
+                throw invalid_argument_params{"A bool member can only be bound to an option"};
+            }
+            p.wants_value = false;
+            p.action      = [member](parse_target target, std::string_view, std::string_view) {
+                target.get<Config>().*member = true;
+            };
+        } else {
+            if (not p.wants_value) {
+                throw invalid_argument_params{"Only a bool member can be bound to a flag"};
+            }
+            if constexpr (detail::bound_member_traits<M>::appends) {
+                p.can_repeat = true;
+            }
+            p.action = [member](parse_target target, std::string_view, std::string_view value) {
+                detail::store_bound_value(target.get<Config>().*member, value);
+            };
+            using value_type = typename detail::bound_member_traits<M>::value_type;
+            if constexpr (std::is_arithmetic_v<value_type>) {
+                // Actions do not run in a dry run, so the conversion is checked here as well
+                p.validate = [user = std::move(p.validate)](std::string_view spelling,
+                                                            std::string_view value) {
+                    (void)detail::convert_bound_value<value_type>(value);
+                    if (user) {
+                        user(spelling, value);
+                    }
+                };
+            }
+        }
+        return parser.add_argument(std::move(p));
+    }
+
+    /// Parse the words, storing the bound arguments into `into`
+    template <std::ranges::input_range R>
+    void parse_args(R&& r, Config& into, params::for_parse p = {}) const {
+        p.target = into;
+        _parser.parse_args(NEO_FWD(r), std::move(p));
+    }
+
+    /// Parse the words into a value-initialized Config
+    template <std::ranges::input_range R>
+    Config parse_args(R&& r, params::for_parse p = {}) const {
+        Config ret{};
+        parse_args(NEO_FWD(r), ret, std::move(p));
+        return ret;
+    }
+
+    /// Parse the arguments given to main(), storing the bound arguments into `into`
+    void parse_main_argv(int                argc,
+                         const char* const* argv,
+                         Config&            into,
+                         params::for_parse  p = {}) const {
+        p.target = into;
+        _parser.parse_main_argv(argc, argv, std::move(p));
+    }
+};
+
+}  // namespace debate
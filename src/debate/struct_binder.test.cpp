@@ -0,0 +1,134 @@
+#include "./struct_binder.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct build_config {
+    std::string              output;
+    int                      jobs    = 1;
+    double                   ratio   = 0;
+    bool                     verbose = false;
+    std::optional<unsigned>  limit;
+    std::vector<std::string> defines;
+    std::filesystem::path    input;
+    std::vector<int>         levels;
+};
+
+debate::struct_binder<build_config> make_binder() {
+    debate::struct_binder<build_config> binder{{.prog = "build"}};
+    binder.bind(&build_config::output, {.names = {"--output", "-o"}});
+    binder.bind(&build_config::jobs, {.names = {"--jobs", "-j"}});
+    binder.bind(&build_config::ratio, {.names = {"--ratio"}});
+    binder.bind(&build_config::verbose, {.names = {"--verbose", "-v"}});
+    binder.bind(&build_config::limit, {.names = {"--limit"}});
+    binder.bind(&build_config::defines, {.names = {"--define", "-D"}});
+    binder.bind(&build_config::levels, {.names = {"--levels"}, .delimiter = ','});
+    binder.bind(&build_config::input, {.names = {"input"}});
+    return binder;
+}
+
+}  // namespace
+
+TEST_CASE("Bind arguments to the members of a struct") {
+    auto binder = make_binder();
+
+    auto cfg = binder.parse_args(std::vector<std::string>{
+        "-vj8",
+        "--output=out.bin",
+        "--ratio",
+        "0.25",
+        "-DA=1",
+        "--levels=1,2,3",
+        "--define",
+        "B",
+        "main.cpp",
+    });
+    CHECK(cfg.output == "out.bin");
+    CHECK(cfg.jobs == 8);
+    CHECK(cfg.ratio == 0.25);
+    CHECK(cfg.verbose);
+    CHECK_FALSE(cfg.limit.has_value());
+    CHECK(cfg.defines == std::vector<std::string>{"A=1", "B"});
+    CHECK(cfg.levels == std::vector<int>{1, 2, 3});
+    CHECK(cfg.input == "main.cpp");
+
+    build_config into;
+    binder.parse_args(std::vector<std::string>{"--limit=5", "x"}, into);
+    CHECK(into.limit == 5u);
+    CHECK(into.jobs == 1);
+    CHECK_FALSE(into.verbose);
+
+    // Values are checked against the member type
+    CHECK_THROWS_AS(binder.parse_args(std::vector<std::string>{"-j", "many", "x"}),
+                    debate::invalid_argument_value);
+    CHECK_THROWS_AS(binder.parse_args(std::vector<std::string>{"-j", "8x", "x"}),
+                    debate::invalid_argument_value);
+    CHECK_THROWS_AS(binder.parse_args(std::vector<std::string>{"--limit=-1", "x"}),
+                    debate::invalid_argument_value);
+}
+
+TEST_CASE("Bound values are converted in a dry run") {
+    auto         binder = make_binder();
+    build_config cfg;
+    binder.parse_args(std::vector<std::string>{"--jobs=4", "x"}, cfg, {.run_actions = false});
+    CHECK(cfg.jobs == 1);
+    CHECK_THROWS_AS(binder.parse_args(std::vector<std::string>{"--jobs=abc", "x"},
+                                      cfg,
+                                      {.run_actions = false}),
+                    debate::invalid_argument_value);
+    CHECK_THROWS_AS(binder.parse_args(std::vector<std::string>{"--levels=1,b", "x"},
+                                      cfg,
+                                      {.run_actions = false}),
+                    debate::invalid_argument_value);
+
+    // A validator of the params still runs after the conversion
+    debate::struct_binder<build_config> checked;
+    std::vector<std::string>            validated;
+    checked.bind(&build_config::jobs,
+                 {
+                     .names    = {"--jobs"},
+                     .validate = [&](auto, auto value) { validated.emplace_back(value); },
+                 });
+    checked.parse_args(std::vector<std::string>{"--jobs=3"}, {.run_actions = false});
+    CHECK(validated == std::vector<std::string>{"3"});
+    CHECK_THROWS_AS(checked.parse_args(std::vector<std::string>{"--jobs=x"}),
+                    debate::invalid_argument_value);
+    CHECK(validated.size() == 1);
+}
+
+TEST_CASE("Bound arguments fill a different object on each thread") {
+    auto                      binder = make_binder();
+    std::vector<build_config> results(4);
+    std::vector<std::thread>  threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&, i] {
+            auto jobs = std::to_string(i);
+            binder.parse_args(std::vector<std::string>{"-j", jobs, "in" + jobs},
+                              results[static_cast<std::size_t>(i)]);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (int i = 0; i < 4; ++i) {
+        CHECK(results[static_cast<std::size_t>(i)].jobs == i);
+    }
+}
+
+TEST_CASE("Invalid member bindings") {
+    debate::struct_binder<build_config> binder;
+    CHECK_THROWS_AS(binder.bind(&build_config::verbose, {.names = {"verbose"}}),
+                    debate::invalid_argument_params);
+    CHECK_THROWS_AS(binder.bind(&build_config::jobs, {.names = {"--jobs"}, .wants_value = false}),
+                    debate::invalid_argument_params);
+    CHECK_THROWS_AS(binder.bind(&build_config::jobs,
+                                {.names = {"--jobs"}, .action = debate::null_action}),
+                    debate::invalid_argument_params);
+}